@@ -0,0 +1,205 @@
+#include "bench.hpp"
+
+#include "core.hpp"
+#include "draw_opengl.hpp"
+#include "draw_software.hpp"
+#include "game.hpp"
+#include "platform.hpp"
+#include "simulate.hpp"
+
+#include "fmt/core.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace Bench {
+
+namespace {
+
+using namespace std::string_view_literals;
+using Clock = std::chrono::steady_clock;
+
+auto constexpr scales = std::array {10, 20, 30, 40, 50, 60};
+std::size_t constexpr framesPerRun {120};
+
+struct Scene {
+  std::string_view name;
+  ProgramState::LevelType levelType;
+  int filledRows;
+  bool paused;
+  std::optional<Shape::Type> holdShapeType;
+};
+
+auto constexpr scenes = std::array {
+    Scene {"menu"sv, ProgramState::LevelType::Menu, 0, false, std::nullopt},
+    Scene {"game"sv, ProgramState::LevelType::Game, 6, false, std::nullopt},
+    Scene {"paused"sv, ProgramState::LevelType::Game, 6, true, std::nullopt},
+    Scene {"stack"sv, ProgramState::LevelType::Game, 16, false,
+           Shape::Type::T},
+};
+
+// Everything a scene needs to be simulated and drawn. It runs on a clock that
+// ticks once per frame, so every run draws the same frames.
+struct State {
+  explicit State(Scene const& scene)
+      : gameState {menuState.level, GameClock::time_point {}} {
+    programState.frameStartClock = GameClock::time_point {};
+    programState.levelType = scene.levelType;
+    gameState.paused = scene.paused;
+    gameState.holdShapeType = scene.holdShapeType;
+
+    // Every row gets a hole, so none of them are cleared.
+    auto& board = gameState.board;
+    for (int row {0}; row < scene.filledRows; ++row) {
+      auto const y = Board::rows - 1 - row;
+      auto const hole = (row * 3) % Board::columns;
+      for (int x {0}; x < Board::columns; ++x) {
+        if (x != hole) {
+          board.block_at(y * Board::columns + x) =
+              Block {static_cast<Block::Kind>(1 + (x + row) % 7)};
+        }
+      }
+    }
+    gameState.currentShapeShadow = board.get_shadow(gameState.currentShape);
+  }
+
+  auto step() -> void {
+    programState.frameStartClock += ProgramState::targetFrameTime;
+    simulate(programState, gameState, menuState);
+  }
+
+  ProgramState programState {};
+  MenuState menuState {};
+  GameState gameState;
+};
+
+struct Result {
+  double framesPerSecond;
+  double p50Milliseconds;
+  double p99Milliseconds;
+  double kibPerFrame;
+};
+
+// Times drawing the scene's frames. draw_frame(state) draws a frame and
+// returns how many bytes of the frame it touched.
+template <typename DrawFrame>
+[[nodiscard]] auto measure(Scene const& scene, DrawFrame&& draw_frame)
+    -> Result {
+  State state {scene};
+  // The first frame fills the renderer's caches.
+  state.step();
+  draw_frame(state);
+
+  std::vector<Clock::duration> frameTimes {};
+  frameTimes.reserve(framesPerRun);
+  u64 bytes {0};
+  for (std::size_t i {0}; i < framesPerRun; ++i) {
+    state.step();
+    auto const start = Clock::now();
+    bytes += draw_frame(state);
+    frameTimes.push_back(Clock::now() - start);
+  }
+
+  Clock::duration total {};
+  for (auto const frameTime : frameTimes) {
+    total += frameTime;
+  }
+  std::sort(frameTimes.begin(), frameTimes.end());
+  auto const percentile = [&frameTimes](std::size_t const p) {
+    auto const i = std::min(frameTimes.size() - 1, frameTimes.size() * p / 100);
+    return std::chrono::duration<double, std::milli> {frameTimes[i]}.count();
+  };
+
+  return {static_cast<double>(framesPerRun) /
+              std::chrono::duration<double> {total}.count(),
+          percentile(50), percentile(99),
+          static_cast<double>(bytes) / framesPerRun / 1024.};
+}
+
+auto print_header() -> void {
+  fmt::print("{:<8} {:>5} {:>7} {:>6} {:>9} {:>7} {:>7} {:>9}\n", "scene",
+             "scale", "threads", "redraw", "frames/s", "p50 ms", "p99 ms",
+             "KiB/frame");
+}
+
+auto print_result(Scene const& scene, int const scale,
+                  std::size_t const threads, std::string_view const redraw,
+                  Result const& result) -> void {
+  fmt::print("{:<8} {:>5} {:>7} {:>6} {:>9.1f} {:>7.3f} {:>7.3f} {:>9.1f}\n",
+             scene.name, scale, threads, redraw, result.framesPerSecond,
+             result.p50Milliseconds, result.p99Milliseconds,
+             result.kibPerFrame);
+}
+
+// Powers of two up to the amount of hardware threads, and that amount.
+[[nodiscard]] auto thread_counts() -> std::vector<std::size_t> {
+  std::size_t const maxThreads {
+      std::max(1U, std::thread::hardware_concurrency())};
+  std::vector<std::size_t> counts {};
+  for (std::size_t count {1}; count < maxThreads; count *= 2) {
+    counts.push_back(count);
+  }
+  counts.push_back(maxThreads);
+  return counts;
+}
+
+} // namespace
+
+auto run_software() -> void {
+  fmt::print("Software renderer ({} frames per run)\n", framesPerRun);
+  print_header();
+  auto const threadCounts = thread_counts();
+  for (auto const& scene : scenes) {
+    for (auto const scale : scales) {
+      change_window_scale(scale);
+      for (auto const threads : threadCounts) {
+        SoftwareRender::set_thread_count(threads);
+        for (auto const fullRedraw : {true, false}) {
+          auto const result = measure(scene, [fullRedraw](State& state) {
+            if (fullRedraw) {
+              SoftwareRender::invalidate();
+            }
+            auto const rects =
+                SoftwareRender::draw(state.programState, state.gameState);
+            swap_buffer(rects);
+
+            u64 bytes {0};
+            auto const bpp = bytes_per_pixel(get_back_buffer().format);
+            for (auto const& rect : rects) {
+              bytes += static_cast<u64>(rect.w * rect.h * bpp);
+            }
+            return bytes;
+          });
+          auto const redraw = fullRedraw ? "full"sv : "damage"sv;
+          print_result(scene, scale, threads, redraw, result);
+        }
+      }
+    }
+  }
+  SoftwareRender::set_thread_count(std::thread::hardware_concurrency());
+}
+
+auto run_opengl() -> void {
+  fmt::print("OpenGL renderer ({} frames per run)\n", framesPerRun);
+  print_header();
+  for (auto const& scene : scenes) {
+    for (auto const scale : scales) {
+      change_window_scale(scale);
+      auto const result = measure(scene, [](State& state) {
+        OpenGLRender::draw(state.programState, state.gameState);
+        // Waits for the frame to be drawn, without waiting for vsync.
+        glFinish();
+        auto const dimensions = get_window_dimensions();
+        return static_cast<u64>(dimensions.w * dimensions.h * 4);
+      });
+      print_result(scene, scale, 1, "full"sv, result);
+    }
+  }
+}
+
+} // namespace Bench
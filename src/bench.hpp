@@ -0,0 +1,14 @@
+#pragma once
+
+// Renders a fixed set of scenes at a range of window scales and prints how
+// long the frames took, so the renderers can be compared with each other and
+// with earlier versions of themselves.
+namespace Bench {
+
+// Every scene at every scale and thread count, once redrawing all of every
+// frame and once only the damage. Has to be run in offscreen mode.
+auto run_software() -> void;
+// Every scene at every scale. Has to be run in OpenGL mode.
+auto run_opengl() -> void;
+
+} // namespace Bench
@@ -0,0 +1,361 @@
+#include "blend.hpp"
+
+#include <array>
+#include <cstring>
+
+#if defined(__SSE2__) or defined(_M_X64) or                                  \
+    (defined(_M_IX86_FP) and _M_IX86_FP >= 2)
+#define BLEND_SSE2
+#include <emmintrin.h>
+#endif
+
+// The AVX2 path is compiled for that target on its own and only called after
+// checking the CPU, so the rest of the program still runs on any x86-64.
+#if defined(BLEND_SSE2) and (defined(__GNUC__) or defined(_MSC_VER))
+#define BLEND_AVX2
+#include <immintrin.h>
+#if defined(_MSC_VER) and not defined(__clang__)
+#include <intrin.h>
+#define BLEND_TARGET_AVX2
+#else
+#define BLEND_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace Blend {
+
+using SpanFunction = void (*)(u8* pixels, std::size_t count,
+                              Color::RGBA color);
+using CoverageFunction = void (*)(u8* pixels, u8 const* coverage,
+                                  std::size_t count, Color::RGBA color);
+
+// x / 255 rounded to the nearest integer, for any x up to 255 * 255.
+[[nodiscard]] auto static constexpr div255(uint x) -> uint {
+  x += 128;
+  return (x + (x >> 8U)) >> 8U;
+}
+
+// The color's channels in the order they are stored in, with the alpha byte
+// of the destination becoming opaque wherever the color covers it.
+[[nodiscard]] auto static constexpr channels(Color::RGBA const color)
+    -> std::array<u8, 4> {
+  return {u8 {color.b}, u8 {color.g}, u8 {color.r},
+          Color::RGBA::maxChannelValue};
+}
+
+auto static blend_pixel(u8* const pixel, u8 const bytesPerPixel,
+                        std::array<u8, 4> const& color, uint const alpha)
+    -> void {
+  auto const inverseAlpha = Color::RGBA::maxChannelValue - alpha;
+  for (std::size_t c {0}; c < bytesPerPixel; ++c) {
+    pixel[c] =
+        static_cast<u8>(div255(pixel[c] * inverseAlpha + color[c] * alpha));
+  }
+}
+
+auto static fill(u8* const pixels, std::size_t const count,
+                 u8 const bytesPerPixel, std::array<u8, 4> const& color)
+    -> void {
+  if (bytesPerPixel == 4) {
+    u32 pixel {};
+    std::memcpy(&pixel, color.data(), sizeof(pixel));
+    std::size_t i {0};
+#if defined(BLEND_SSE2)
+    auto const wide = _mm_set1_epi32(static_cast<int>(pixel));
+    for (; i + 4 <= count; i += 4) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i * 4), wide);
+    }
+#endif
+    for (; i < count; ++i) {
+      std::memcpy(pixels + i * 4, &pixel, sizeof(pixel));
+    }
+    return;
+  }
+
+  for (std::size_t i {0}; i < count; ++i) {
+    std::memcpy(pixels + i * bytesPerPixel, color.data(), bytesPerPixel);
+  }
+}
+
+auto static span_scalar(u8* const pixels, std::size_t const count,
+                        Color::RGBA const color) -> void {
+  auto const colorChannels = channels(color);
+  for (std::size_t i {0}; i < count; ++i) {
+    blend_pixel(pixels + i * 4, 4, colorChannels, u8 {color.a});
+  }
+}
+
+auto static coverage_span_scalar(u8* const pixels, u8 const* const coverage,
+                                 std::size_t const count,
+                                 Color::RGBA const color) -> void {
+  auto const colorChannels = channels(color);
+  for (std::size_t i {0}; i < count; ++i) {
+    blend_pixel(pixels + i * 4, 4, colorChannels,
+                div255(uint {coverage[i]} * u8 {color.a}));
+  }
+}
+
+#if defined(BLEND_SSE2)
+// Blends 8 channels (2 pixels) widened to 16 bits.
+[[nodiscard]] auto static blend_sse2(__m128i const background,
+                                     __m128i const foreground,
+                                     __m128i const alpha) -> __m128i {
+  auto const inverseAlpha =
+      _mm_sub_epi16(_mm_set1_epi16(Color::RGBA::maxChannelValue), alpha);
+  // The sum is at most 255 * 255 + 128, which still fits in 16 bits.
+  auto sum = _mm_add_epi16(_mm_mullo_epi16(background, inverseAlpha),
+                           _mm_mullo_epi16(foreground, alpha));
+  sum = _mm_add_epi16(sum, _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(sum, _mm_srli_epi16(sum, 8)), 8);
+}
+
+[[nodiscard]] auto static foreground_sse2(Color::RGBA const color) -> __m128i {
+  auto const c = channels(color);
+  return _mm_set_epi16(c[3], c[2], c[1], c[0], c[3], c[2], c[1], c[0]);
+}
+
+auto static span_sse2(u8* const pixels, std::size_t const count,
+                      Color::RGBA const color) -> void {
+  auto const zero = _mm_setzero_si128();
+  auto const foreground = foreground_sse2(color);
+  auto const alpha = _mm_set1_epi16(static_cast<short>(u8 {color.a}));
+  std::size_t i {0};
+  for (; i + 4 <= count; i += 4) {
+    auto* const address = reinterpret_cast<__m128i*>(pixels + i * 4);
+    auto const background = _mm_loadu_si128(address);
+    auto const low = blend_sse2(_mm_unpacklo_epi8(background, zero),
+                                foreground, alpha);
+    auto const high = blend_sse2(_mm_unpackhi_epi8(background, zero),
+                                 foreground, alpha);
+    _mm_storeu_si128(address, _mm_packus_epi16(low, high));
+  }
+  span_scalar(pixels + i * 4, count - i, color);
+}
+
+auto static coverage_span_sse2(u8* const pixels, u8 const* const coverage,
+                               std::size_t const count,
+                               Color::RGBA const color) -> void {
+  auto const zero = _mm_setzero_si128();
+  auto const foreground = foreground_sse2(color);
+  auto const colorAlpha = _mm_set1_epi16(static_cast<short>(u8 {color.a}));
+  std::size_t i {0};
+  for (; i + 4 <= count; i += 4) {
+    u32 coverage4 {};
+    std::memcpy(&coverage4, coverage + i, sizeof(coverage4));
+    // Glyphs are mostly empty space around the outline.
+    if (coverage4 == 0) {
+      continue;
+    }
+
+    // Every pixel's alpha, repeated for each of its 4 channels.
+    auto alphas = _mm_unpacklo_epi8(
+        _mm_cvtsi32_si128(static_cast<int>(coverage4)), zero);
+    alphas = blend_sse2(zero, alphas, colorAlpha);
+    alphas = _mm_unpacklo_epi16(alphas, alphas);
+    auto const lowAlpha = _mm_unpacklo_epi32(alphas, alphas);
+    auto const highAlpha = _mm_unpackhi_epi32(alphas, alphas);
+
+    auto* const address = reinterpret_cast<__m128i*>(pixels + i * 4);
+    auto const background = _mm_loadu_si128(address);
+    auto const low = blend_sse2(_mm_unpacklo_epi8(background, zero),
+                                foreground, lowAlpha);
+    auto const high = blend_sse2(_mm_unpackhi_epi8(background, zero),
+                                 foreground, highAlpha);
+    _mm_storeu_si128(address, _mm_packus_epi16(low, high));
+  }
+  coverage_span_scalar(pixels + i * 4, coverage + i, count - i, color);
+}
+#endif
+
+#if defined(BLEND_AVX2)
+// Blends 16 channels (4 pixels) widened to 16 bits, with the foreground
+// already multiplied by alpha and rounded.
+BLEND_TARGET_AVX2 [[nodiscard]] auto static blend_avx2(
+    __m256i const background, __m256i const inverseAlpha,
+    __m256i const foregroundAlpha) -> __m256i {
+  auto const sum = _mm256_add_epi16(
+      _mm256_mullo_epi16(background, inverseAlpha), foregroundAlpha);
+  return _mm256_srli_epi16(_mm256_add_epi16(sum, _mm256_srli_epi16(sum, 8)),
+                           8);
+}
+
+BLEND_TARGET_AVX2 auto static span_avx2(u8* const pixels,
+                                        std::size_t const count,
+                                        Color::RGBA const color) -> void {
+  auto const c = channels(color);
+  auto const zero = _mm256_setzero_si256();
+  auto const foreground =
+      _mm256_set_epi16(c[3], c[2], c[1], c[0], c[3], c[2], c[1], c[0], c[3],
+                       c[2], c[1], c[0], c[3], c[2], c[1], c[0]);
+  auto const alpha = _mm256_set1_epi16(static_cast<short>(u8 {color.a}));
+  auto const inverseAlpha = _mm256_sub_epi16(
+      _mm256_set1_epi16(Color::RGBA::maxChannelValue), alpha);
+  auto const foregroundAlpha = _mm256_add_epi16(
+      _mm256_mullo_epi16(foreground, alpha), _mm256_set1_epi16(128));
+
+  std::size_t i {0};
+  // Unpacking and packing both work within 128 bit lanes, so the pixels end
+  // up back in their original order.
+  for (; i + 8 <= count; i += 8) {
+    auto* const address = reinterpret_cast<__m256i*>(pixels + i * 4);
+    auto const background = _mm256_loadu_si256(address);
+    auto const low = blend_avx2(_mm256_unpacklo_epi8(background, zero),
+                                inverseAlpha, foregroundAlpha);
+    auto const high = blend_avx2(_mm256_unpackhi_epi8(background, zero),
+                                 inverseAlpha, foregroundAlpha);
+    _mm256_storeu_si256(address, _mm256_packus_epi16(low, high));
+  }
+  span_sse2(pixels + i * 4, count - i, color);
+}
+
+[[nodiscard]] auto static cpu_supports_avx2() -> bool {
+#if defined(_MSC_VER) and not defined(__clang__)
+  std::array<int, 4> info {};
+  __cpuid(info.data(), 1);
+  auto const osSavesYmm = (info[2] & (1 << 27)) != 0 and
+                          (_xgetbv(0) & 0x6U) == 0x6U;
+  __cpuidex(info.data(), 7, 0);
+  return osSavesYmm and (info[1] & (1 << 5)) != 0;
+#else
+  return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+namespace {
+
+struct Kernels {
+  SpanFunction span;
+  CoverageFunction coverageSpan;
+  char const* name;
+};
+
+[[nodiscard]] auto select_kernels() -> Kernels {
+#if defined(BLEND_AVX2)
+  if (cpu_supports_avx2()) {
+    return {&span_avx2, &coverage_span_sse2, "AVX2"};
+  }
+#endif
+#if defined(BLEND_SSE2)
+  return {&span_sse2, &coverage_span_sse2, "SSE2"};
+#else
+  return {&span_scalar, &coverage_span_scalar, "scalar"};
+#endif
+}
+
+[[nodiscard]] auto kernels() -> Kernels const& {
+  static Kernels const selected {select_kernels()};
+  return selected;
+}
+
+} // namespace
+
+// RGB565 is widened to 8 bits per channel to be blended, and the blended
+// channels are cut back down.
+[[nodiscard]] auto static constexpr pack_rgb565(uint const r, uint const g,
+                                                uint const b) -> u16 {
+  return static_cast<u16>(((r >> 3U) << 11U) | ((g >> 2U) << 5U) | (b >> 3U));
+}
+
+auto static blend_rgb565(u8* const pixel, Color::RGBA const color,
+                         uint const alpha) -> void {
+  u16 packed {};
+  std::memcpy(&packed, pixel, sizeof(packed));
+  uint const r {(packed >> 11U) & 0x1FU};
+  uint const g {(packed >> 5U) & 0x3FU};
+  uint const b {packed & 0x1FU};
+  auto const inverseAlpha = Color::RGBA::maxChannelValue - alpha;
+  auto const blend = [alpha, inverseAlpha](uint const background,
+                                           uint const foreground) {
+    return div255(background * inverseAlpha + foreground * alpha);
+  };
+  packed = pack_rgb565(blend((r << 3U) | (r >> 2U), u8 {color.r}),
+                       blend((g << 2U) | (g >> 4U), u8 {color.g}),
+                       blend((b << 3U) | (b >> 2U), u8 {color.b}));
+  std::memcpy(pixel, &packed, sizeof(packed));
+}
+
+template <PixelFormat format>
+auto span(u8* const pixels, std::size_t const count, Color::RGBA const color)
+    -> void {
+  auto constexpr bytesPerPixel = bytes_per_pixel(format);
+  u8 const alpha {color.a};
+  if (alpha == Color::RGBA::Alpha::transparent or count == 0) {
+    return;
+  }
+
+  if constexpr (format == PixelFormat::RGB565) {
+    if (alpha == Color::RGBA::maxChannelValue) {
+      auto const packed = pack_rgb565(u8 {color.r}, u8 {color.g}, u8 {color.b});
+      for (std::size_t i {0}; i < count; ++i) {
+        std::memcpy(pixels + i * bytesPerPixel, &packed, sizeof(packed));
+      }
+      return;
+    }
+    for (std::size_t i {0}; i < count; ++i) {
+      blend_rgb565(pixels + i * bytesPerPixel, color, alpha);
+    }
+  } else {
+    if (alpha == Color::RGBA::maxChannelValue) {
+      fill(pixels, count, bytesPerPixel, channels(color));
+      return;
+    }
+    if constexpr (bytesPerPixel == 4) {
+      kernels().span(pixels, count, color);
+    } else {
+      auto const colorChannels = channels(color);
+      for (std::size_t i {0}; i < count; ++i) {
+        blend_pixel(pixels + i * bytesPerPixel, bytesPerPixel, colorChannels,
+                    alpha);
+      }
+    }
+  }
+}
+
+template <PixelFormat format>
+auto coverage_span(u8* const pixels, u8 const* const coverage,
+                   std::size_t const count, Color::RGBA const color) -> void {
+  auto constexpr bytesPerPixel = bytes_per_pixel(format);
+  if (u8 {color.a} == Color::RGBA::Alpha::transparent or count == 0) {
+    return;
+  }
+
+  if constexpr (format == PixelFormat::RGB565) {
+    for (std::size_t i {0}; i < count; ++i) {
+      if (coverage[i] != 0) {
+        blend_rgb565(pixels + i * bytesPerPixel, color,
+                     div255(uint {coverage[i]} * u8 {color.a}));
+      }
+    }
+  } else if constexpr (bytesPerPixel == 4) {
+    kernels().coverageSpan(pixels, coverage, count, color);
+  } else {
+    auto const colorChannels = channels(color);
+    for (std::size_t i {0}; i < count; ++i) {
+      blend_pixel(pixels + i * bytesPerPixel, bytesPerPixel, colorChannels,
+                  div255(uint {coverage[i]} * u8 {color.a}));
+    }
+  }
+}
+
+template auto span<PixelFormat::XRGB8888>(u8*, std::size_t, Color::RGBA)
+    -> void;
+template auto span<PixelFormat::ARGB8888>(u8*, std::size_t, Color::RGBA)
+    -> void;
+template auto span<PixelFormat::RGB565>(u8*, std::size_t, Color::RGBA)
+    -> void;
+template auto span<PixelFormat::BGR24>(u8*, std::size_t, Color::RGBA) -> void;
+template auto coverage_span<PixelFormat::XRGB8888>(u8*, u8 const*,
+                                                   std::size_t, Color::RGBA)
+    -> void;
+template auto coverage_span<PixelFormat::ARGB8888>(u8*, u8 const*,
+                                                   std::size_t, Color::RGBA)
+    -> void;
+template auto coverage_span<PixelFormat::RGB565>(u8*, u8 const*, std::size_t,
+                                                 Color::RGBA) -> void;
+template auto coverage_span<PixelFormat::BGR24>(u8*, u8 const*, std::size_t,
+                                                Color::RGBA) -> void;
+
+auto implementation_name() -> char const* { return kernels().name; }
+
+} // namespace Blend
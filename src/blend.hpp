@@ -0,0 +1,31 @@
+#pragma once
+
+#include "util.hpp"
+
+#include "jint.h"
+
+#include <cstddef>
+
+// Alpha blending for the software renderer, a horizontal span of pixels at a
+// time. It's specialized for every pixel format, so the format is picked
+// once per frame rather than per pixel. Everything is done in 8 bit fixed
+// point, with SSE2 as the baseline on x86 and an AVX2 path that is picked at
+// run time if the CPU supports it. The 4th byte of 32 bit pixels becomes
+// opaque wherever they're drawn over.
+namespace Blend {
+
+// Blends the color over `count` pixels. Opaque colors are filled without
+// reading the pixels, and fully transparent ones are skipped.
+template <PixelFormat format>
+auto span(u8* pixels, std::size_t count, Color::RGBA color) -> void;
+
+// Like span(), but every pixel's alpha is further scaled by its coverage,
+// e.g. a glyph's bitmap.
+template <PixelFormat format>
+auto coverage_span(u8* pixels, u8 const* coverage, std::size_t count,
+                   Color::RGBA color) -> void;
+
+// The name of the code path span() uses on this CPU.
+[[nodiscard]] auto implementation_name() -> char const*;
+
+} // namespace Blend
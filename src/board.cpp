@@ -8,99 +8,14 @@
 #include <iostream>
 #include <optional>
 
-auto Board::get_shadow(Shape const& shape) const -> Shape {
-  auto shapeShadow = shape;
-  while (try_move(shapeShadow, V2::down())) {
-    // Intentionally empty body.
-  }
-  shapeShadow.color.a = Color::RGBA::Alpha::opaque / 2U;
-  return shapeShadow;
-}
-
-auto Board::try_move(Shape& shape, V2 const move) const -> bool {
-  if (is_valid_move(shape, move)) {
-    shape.translate(move);
-    return true;
-  }
-  return false;
-}
-
-auto Board::rotate_shape(Shape& shape, Shape::RotationDirection const dir) const
-    -> std::optional<Shape::RotationType> {
-  auto rotatingShape = shape;
-  rotatingShape.rotate(dir);
-  if (is_valid_shape(rotatingShape)) {
-    shape = rotatingShape;
-    return Shape::RotationType::Regular;
-  }
-
-  // Something is blocking the shape after just rotating it, so it has to be
-  // kicked into a valid position if possible.
-  for (auto const kickMove : shape.get_wallkicks(dir)) {
-    // rotatingShape already has the new rotation, but has to reset its
-    // position every time it checks a new kick.
-    rotatingShape.pos = shape.pos;
-    // the y in kicks is bottom up while it's top down for the shape
-    // position so we have to negate it for the translation.
-    rotatingShape.translate({kickMove.x, -kickMove.y});
-    if (is_valid_shape(rotatingShape)) {
-      shape = rotatingShape;
-      return Shape::RotationType::Wallkick;
-    }
-  }
-  return std::nullopt;
-}
-
-auto Board::is_valid_spot(Point<int> const pos) const -> bool {
-  if (point_is_in_rect(pos, {0, 0, columns, rows})) {
-    gsl::index const index {pos.y * columns + pos.x};
-    return not block_at(index).isActive;
-  }
-  return false;
-}
-
-auto Board::is_valid_move(Shape shape, V2 const move) const -> bool {
-  shape.translate(move);
-  return is_valid_shape(shape);
-}
-
-auto Board::is_valid_shape(Shape const& shape) const -> bool {
-  auto const blockPositions = shape.get_absolute_block_positions();
-  return all_of(blockPositions, [this](auto const& position) {
-    return is_valid_spot(position);
-  });
-}
-
-// If the shape is a T, its last movement was a rotation, and 3 or more of its
-// corners are occupied by other pieces it counts as a T-spin. If the rotation
-// was a wallkick it only counts as a T-spin mini.
-auto Board::check_for_tspin(Shape const& shape,
-                            Shape::RotationType const rotationType) const
-    -> std::optional<TspinType> {
-  if (shape.type() == Shape::Type::T) {
-    std::array<V2, 4> static constexpr cornerOffsets {
-        V2 {0, 0}, {2, 0}, {0, 2}, {2, 2}};
-    auto const cornersOccupied =
-        count_if(cornerOffsets, [this, &shape](auto const& offset) {
-          return not is_valid_spot(shape.pos + offset);
-        });
-    if (cornersOccupied >= 3) {
-      return (rotationType == Shape::RotationType::Wallkick)
-                 ? TspinType::Mini
-                 : TspinType::Regular;
-    }
-  }
-  return std::nullopt;
-}
-
-auto Board::get_cleared_rows() const -> ArrayStack<u8, Shape::maxHeight> {
-  ArrayStack<u8, Shape::maxHeight> rowsCleared;
+auto Board::get_cleared_rows() const -> ArrayStack<u8, ShapeBase::maxHeight> {
+  ArrayStack<u8, ShapeBase::maxHeight> rowsCleared;
 
   for (u8 y {0}; y < rows; ++y) {
     auto const rowStartIt = m_data.cbegin() + (y * columns);
     auto const rowEndIt = m_data.cbegin() + ((y + 1) * columns);
     auto const rowIsFull = std::all_of(
-        rowStartIt, rowEndIt, [](auto const& block) { return block.isActive; });
+        rowStartIt, rowEndIt, [](auto const& block) { return block.is_active(); });
     if (rowIsFull) {
       rowsCleared.push_back(y);
     }
@@ -128,8 +43,7 @@ auto Board::remove_full_rows() -> u8 {
       auto& oldBlock = block_at(index);
       auto& newBlock = block_at(newIndex);
       newBlock = oldBlock;
-      oldBlock.isActive = false;
-      oldBlock.color = Color::black;
+      oldBlock = {Block::Kind::Empty};
     }
   };
 
@@ -166,3 +80,27 @@ auto Board::remove_full_rows() -> u8 {
 
   return gsl::narrow_cast<u8>(rowsCleared.size());
 }
+
+// Pushes every row up and fills the bottom `count` rows with garbage, leaving
+// a hole in the same column of each. Returns false if any blocks got pushed
+// out of the top of the board.
+auto Board::add_garbage_rows(u8 count, u8 const holeColumn) -> bool {
+  assert(holeColumn < columns);
+  count = std::min(count, rows);
+  auto const garbageStart = m_data.begin() + count * columns;
+
+  auto const toppedOut =
+      std::any_of(m_data.begin(), garbageStart,
+                  [](auto const& block) { return block.is_active(); });
+
+  std::move(garbageStart, m_data.end(), m_data.begin());
+  for (auto y = rows - count; y < rows; ++y) {
+    for (u8 x {0}; x < columns; ++x) {
+      auto const index = gsl::narrow_cast<gsl::index>(y * columns + x);
+      block_at(index) = (x == holeColumn) ? Block {Block::Kind::Empty}
+                                          : Block {Block::Kind::Garbage};
+    }
+  }
+
+  return not toppedOut;
+}
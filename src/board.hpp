@@ -1,16 +1,56 @@
 #pragma once
 
 #include "jint.h"
+#include "rangealgorithms.hpp"
 #include "shape.hpp"
 #include "util.hpp"
 
 #include <array>
 #include <optional>
 
+// A board cell only stores what kind of block fills it, so a whole board fits
+// in a couple of hundred bytes and a GameState stays cheap to snapshot.
 struct Block {
-  Color::RGBA color = Color::invalid;
-  bool isActive {false};
+  enum class Kind : u8 { Empty, I, O, L, J, S, Z, T, Garbage };
+
+  [[nodiscard]] auto static constexpr from(ShapeBase::Type const type)
+      -> Block {
+    // Kind lists the shapes in the same order as ShapeBase::Type.
+    return {static_cast<Kind>(static_cast<u8>(type) + 1U)};
+  }
+
+  [[nodiscard]] auto constexpr is_active() const noexcept -> bool {
+    return kind != Kind::Empty;
+  }
+
+  [[nodiscard]] auto constexpr color() const -> Color::RGBA {
+    switch (kind) {
+    case Kind::Empty:
+      return Color::black;
+    case Kind::Garbage:
+      return Color::garbage;
+    case Kind::I:
+    case Kind::O:
+    case Kind::L:
+    case Kind::J:
+    case Kind::S:
+    case Kind::Z:
+    case Kind::T:
+      return ShapeBase::to_color(
+          static_cast<ShapeBase::Type>(static_cast<u8>(kind) - 1U));
+    }
+    // Unreachable.
+    std::terminate();
+  }
+
+  template <typename Archive>
+  auto serialize(Archive& archive) -> void {
+    archive(kind);
+  }
+
+  Kind kind {Kind::Empty};
 };
+static_assert(sizeof(Block) == 1);
 
 enum class TspinType { Regular, Mini };
 
@@ -28,23 +68,157 @@ public:
     return gsl::at(m_data, i);
   }
 
-  auto rotate_shape(Shape& shape, Shape::RotationDirection dir) const
-      -> std::optional<Shape::RotationType>;
-  auto try_move(Shape& shape, V2 move) const -> bool;
-  [[nodiscard]] auto get_shadow(Shape const& shape) const -> Shape;
-  [[nodiscard]] auto check_for_tspin(Shape const& shape,
-                                     Shape::RotationType rotationType) const
+  // The shape's rotation system is a compile time policy, so the rotation
+  // and collision checks get fully specialized for each one.
+  template <typename System>
+  auto rotate_shape(BasicShape<System>& shape,
+                    ShapeBase::RotationDirection dir) const
+      -> std::optional<ShapeBase::RotationType>;
+  template <typename System>
+  auto try_move(BasicShape<System>& shape, V2 move) const -> bool;
+  template <typename System>
+  [[nodiscard]] auto get_shadow(BasicShape<System> const& shape) const
+      -> BasicShape<System>;
+  template <typename System>
+  [[nodiscard]] auto check_for_tspin(BasicShape<System> const& shape,
+                                     ShapeBase::RotationType rotationType) const
       -> std::optional<TspinType>;
   [[nodiscard]] auto is_valid_spot(Point<int> pos) const -> bool;
-  [[nodiscard]] auto is_valid_move(Shape shape, V2 move) const -> bool;
-  [[nodiscard]] auto is_valid_shape(Shape const& shape) const -> bool;
+  // Whether all of the shape's blocks are inside the board, taken or not.
+  template <typename System>
+  [[nodiscard]] auto static is_in_bounds(BasicShape<System> const& shape)
+      -> bool;
+  template <typename System>
+  [[nodiscard]] auto is_valid_move(BasicShape<System> shape, V2 move) const
+      -> bool;
+  template <typename System>
+  [[nodiscard]] auto is_valid_shape(BasicShape<System> const& shape) const
+      -> bool;
   auto remove_full_rows() -> u8;
+  auto add_garbage_rows(u8 count, u8 holeColumn) -> bool;
   auto print_board() const -> void;
 
+  // Visits every field, see snapshot.hpp.
+  template <typename Archive>
+  auto serialize(Archive& archive) -> void {
+    archive(m_data);
+  }
+
 private:
   [[nodiscard]] auto get_cleared_rows() const
-      -> ArrayStack<u8, Shape::maxHeight>;
+      -> ArrayStack<u8, ShapeBase::maxHeight>;
 
   std::array<Block, rows * columns> m_data {
-      make_filled_array<Block, rows * columns>({Color::black, false})};
+      make_filled_array<Block, rows * columns>({Block::Kind::Empty})};
 };
+
+template <typename System>
+auto Board::get_shadow(BasicShape<System> const& shape) const
+    -> BasicShape<System> {
+  auto shapeShadow = shape;
+  while (try_move(shapeShadow, V2::down())) {
+    // Intentionally empty body.
+  }
+  shapeShadow.color.a = Color::RGBA::Alpha::opaque / 2U;
+  return shapeShadow;
+}
+
+template <typename System>
+auto Board::try_move(BasicShape<System>& shape, V2 const move) const -> bool {
+  if (is_valid_move(shape, move)) {
+    shape.translate(move);
+    return true;
+  }
+  return false;
+}
+
+template <typename System>
+auto Board::rotate_shape(BasicShape<System>& shape,
+                         ShapeBase::RotationDirection const dir) const
+    -> std::optional<ShapeBase::RotationType> {
+  auto rotatingShape = shape;
+  rotatingShape.rotate(dir);
+  if (is_valid_shape(rotatingShape)) {
+    shape = rotatingShape;
+    return ShapeBase::RotationType::Regular;
+  }
+
+  // Something is blocking the shape after just rotating it, so it has to be
+  // kicked into a valid position if possible.
+  for (auto const kickMove : shape.get_wallkicks(dir)) {
+    // rotatingShape already has the new rotation, but has to reset its
+    // position every time it checks a new kick.
+    rotatingShape.pos = shape.pos;
+    // the y in kicks is bottom up while it's top down for the shape
+    // position so we have to negate it for the translation.
+    rotatingShape.translate({kickMove.x, -kickMove.y});
+    if (is_valid_shape(rotatingShape)) {
+      shape = rotatingShape;
+      return ShapeBase::RotationType::Wallkick;
+    }
+  }
+  return std::nullopt;
+}
+
+inline auto Board::is_valid_spot(Point<int> const pos) const -> bool {
+  if (point_is_in_rect(pos, {0, 0, columns, rows})) {
+    gsl::index const index {pos.y * columns + pos.x};
+    return not block_at(index).is_active();
+  }
+  return false;
+}
+
+template <typename System>
+auto Board::is_in_bounds(BasicShape<System> const& shape) -> bool {
+  // None of the blocks can be on the board if the layout isn't, and checking
+  // it first keeps far off positions from overflowing.
+  auto const layout = ShapeBase::layoutDimensions;
+  auto const width = gsl::narrow_cast<int>(layout.w);
+  auto const height = gsl::narrow_cast<int>(layout.h);
+  if (not point_is_in_rect(shape.pos,
+                           {-width, -height, columns + width, rows + height})) {
+    return false;
+  }
+  auto const blockPositions = shape.get_absolute_block_positions();
+  return all_of(blockPositions, [](auto const& position) {
+    return point_is_in_rect(position, {0, 0, columns, rows});
+  });
+}
+
+template <typename System>
+auto Board::is_valid_move(BasicShape<System> shape, V2 const move) const
+    -> bool {
+  shape.translate(move);
+  return is_valid_shape(shape);
+}
+
+template <typename System>
+auto Board::is_valid_shape(BasicShape<System> const& shape) const -> bool {
+  auto const blockPositions = shape.get_absolute_block_positions();
+  return all_of(blockPositions, [this](auto const& position) {
+    return is_valid_spot(position);
+  });
+}
+
+// If the shape is a T, its last movement was a rotation, and 3 or more of its
+// corners are occupied by other pieces it counts as a T-spin. If the rotation
+// was a wallkick it only counts as a T-spin mini.
+template <typename System>
+auto Board::check_for_tspin(BasicShape<System> const& shape,
+                            ShapeBase::RotationType const rotationType) const
+    -> std::optional<TspinType> {
+  if (shape.type() == ShapeBase::Type::T) {
+    std::array<V2, 4> static constexpr cornerOffsets {
+        V2 {0, 0}, {2, 0}, {0, 2}, {2, 2}};
+    auto const cornersOccupied =
+        count_if(cornerOffsets, [this, &shape](auto const& offset) {
+          return not is_valid_spot(shape.pos + offset);
+        });
+    if (cornersOccupied >= 3) {
+      return (rotationType == ShapeBase::RotationType::Wallkick)
+                 ? TspinType::Mini
+                 : TspinType::Regular;
+    }
+  }
+  return std::nullopt;
+}
@@ -0,0 +1,346 @@
+#include "capture.hpp"
+
+#include "fmt/core.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <utility>
+
+#if defined(__SSE2__) or defined(_M_X64) or                                  \
+    (defined(_M_IX86_FP) and _M_IX86_FP >= 2)
+#define CAPTURE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Capture {
+
+struct Rgb {
+  uint r;
+  uint g;
+  uint b;
+};
+
+template <PixelFormat format>
+[[nodiscard]] auto static unpack(u8 const* const pixel) -> Rgb {
+  if constexpr (format == PixelFormat::RGB565) {
+    u16 p {};
+    std::memcpy(&p, pixel, sizeof(p));
+    uint const r {(p >> 11U) & 0x1FU};
+    uint const g {(p >> 5U) & 0x3FU};
+    uint const b {p & 0x1FU};
+    return {(r << 3U) | (r >> 2U), (g << 2U) | (g >> 4U),
+            (b << 3U) | (b >> 2U)};
+  } else {
+    // Every other format stores blue, green and red first.
+    return {pixel[2], pixel[1], pixel[0]};
+  }
+}
+
+// Full range BT.601 in 8 bit fixed point. The chroma sums are offset so they
+// never go negative, which lets them be computed in unsigned 16 bit lanes.
+[[nodiscard]] auto static constexpr luma(Rgb const c) -> u8 {
+  return static_cast<u8>((77U * c.r + 150U * c.g + 29U * c.b + 128U) >> 8U);
+}
+[[nodiscard]] auto static constexpr blue_chroma(Rgb const c) -> u8 {
+  return static_cast<u8>((32895U + 128U * c.b - 43U * c.r - 85U * c.g) >> 8U);
+}
+[[nodiscard]] auto static constexpr red_chroma(Rgb const c) -> u8 {
+  return static_cast<u8>((32895U + 128U * c.r - 107U * c.g - 21U * c.b) >> 8U);
+}
+
+#if defined(CAPTURE_SSE2)
+// 8 pixels of 32 bit BGRX split into their channels, widened to 16 bits.
+struct ChannelsSse2 {
+  __m128i r;
+  __m128i g;
+  __m128i b;
+};
+
+[[nodiscard]] auto static load_channels_sse2(u8 const* const pixels)
+    -> ChannelsSse2 {
+  auto const low = _mm_loadu_si128(reinterpret_cast<__m128i const*>(pixels));
+  auto const high =
+      _mm_loadu_si128(reinterpret_cast<__m128i const*>(pixels + 16));
+  auto const mask = _mm_set1_epi32(0xFF);
+  return {_mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(low, 16), mask),
+                          _mm_and_si128(_mm_srli_epi32(high, 16), mask)),
+          _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(low, 8), mask),
+                          _mm_and_si128(_mm_srli_epi32(high, 8), mask)),
+          _mm_packs_epi32(_mm_and_si128(low, mask),
+                          _mm_and_si128(high, mask))};
+}
+
+// Weighs the channels, adds the offset and drops the low 8 bits. The sums
+// wrap around in every lane.
+[[nodiscard]] auto static weigh_sse2(ChannelsSse2 const& c, short const r,
+                                     short const g, short const b,
+                                     short const offset) -> __m128i {
+  auto sum = _mm_add_epi16(_mm_mullo_epi16(c.r, _mm_set1_epi16(r)),
+                           _mm_mullo_epi16(c.g, _mm_set1_epi16(g)));
+  sum = _mm_add_epi16(sum, _mm_mullo_epi16(c.b, _mm_set1_epi16(b)));
+  return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(offset)), 8);
+}
+
+auto static store_luma_sse2(ChannelsSse2 const& c, u8* const y) -> void {
+  auto const luma = weigh_sse2(c, 77, 150, 29, 128);
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(y),
+                   _mm_packus_epi16(luma, luma));
+}
+
+// Averages every 2 by 2 block of pixels of two rows of channels into the
+// low 16 bits of 4 32 bit lanes.
+[[nodiscard]] auto static average_blocks_sse2(__m128i const top,
+                                              __m128i const bottom)
+    -> __m128i {
+  auto const rows = _mm_add_epi16(top, bottom);
+  auto const blocks =
+      _mm_add_epi16(_mm_and_si128(rows, _mm_set1_epi32(0xFFFF)),
+                    _mm_srli_epi32(rows, 16));
+  return _mm_srli_epi16(_mm_add_epi16(blocks, _mm_set1_epi16(2)), 2);
+}
+
+auto static store_chroma_sse2(__m128i chroma, u8* const plane) -> void {
+  chroma = _mm_and_si128(chroma, _mm_set1_epi32(0xFF));
+  chroma = _mm_packs_epi32(chroma, chroma);
+  auto const bytes = _mm_cvtsi128_si32(_mm_packus_epi16(chroma, chroma));
+  std::memcpy(plane, &bytes, 4);
+}
+#endif
+
+// Converts a pair of rows, which is the same row twice if the frame has an
+// odd height.
+template <PixelFormat format>
+auto static convert_row_pair(u8 const* const top, u8 const* const bottom,
+                             int const width, u8* const yTop,
+                             u8* const yBottom, u8* const u, u8* const v)
+    -> void {
+  auto constexpr bpp = bytes_per_pixel(format);
+  int x {0};
+#if defined(CAPTURE_SSE2)
+  if constexpr (bpp == 4) {
+    for (; x + 8 <= width; x += 8) {
+      auto const topChannels = load_channels_sse2(top + x * bpp);
+      auto const bottomChannels = load_channels_sse2(bottom + x * bpp);
+      store_luma_sse2(topChannels, yTop + x);
+      store_luma_sse2(bottomChannels, yBottom + x);
+
+      ChannelsSse2 const blocks {
+          average_blocks_sse2(topChannels.r, bottomChannels.r),
+          average_blocks_sse2(topChannels.g, bottomChannels.g),
+          average_blocks_sse2(topChannels.b, bottomChannels.b)};
+      // The coefficients wrap around, which works out the same as the
+      // unsigned sums since the results fit in 16 bits.
+      auto constexpr offset = static_cast<short>(32895);
+      store_chroma_sse2(weigh_sse2(blocks, -43, -85, 128, offset), u + x / 2);
+      store_chroma_sse2(weigh_sse2(blocks, 128, -107, -21, offset), v + x / 2);
+    }
+  }
+#endif
+
+  for (; x < width; x += 2) {
+    // An odd width's last block is the last column twice.
+    auto const right = std::min(x + 1, width - 1);
+    std::array const block {
+        unpack<format>(top + x * bpp), unpack<format>(top + right * bpp),
+        unpack<format>(bottom + x * bpp), unpack<format>(bottom + right * bpp)};
+    yTop[x] = luma(block[0]);
+    yTop[right] = luma(block[1]);
+    yBottom[x] = luma(block[2]);
+    yBottom[right] = luma(block[3]);
+
+    Rgb sum {2, 2, 2};
+    for (auto const& c : block) {
+      sum.r += c.r;
+      sum.g += c.g;
+      sum.b += c.b;
+    }
+    Rgb const average {sum.r >> 2U, sum.g >> 2U, sum.b >> 2U};
+    u[x / 2] = blue_chroma(average);
+    v[x / 2] = red_chroma(average);
+  }
+}
+
+template <PixelFormat format>
+auto static convert(u8 const* const pixels, std::size_t const pitch,
+                    Rect<int>::Size const size, u8* const y, u8* const u,
+                    u8* const v) -> void {
+  auto const chromaWidth = static_cast<std::size_t>((size.w + 1) / 2);
+  auto const width = static_cast<std::size_t>(size.w);
+  for (int row {0}; row < size.h; row += 2) {
+    auto const bottomRow = std::min(row + 1, size.h - 1);
+    auto const r = static_cast<std::size_t>(row);
+    auto const b = static_cast<std::size_t>(bottomRow);
+    convert_row_pair<format>(pixels + r * pitch, pixels + b * pitch, size.w,
+                             y + r * width, y + b * width,
+                             u + r / 2 * chromaWidth, v + r / 2 * chromaWidth);
+  }
+}
+
+auto to_yuv420(u8 const* const pixels, std::size_t const pitch,
+               PixelFormat const format, Rect<int>::Size const size,
+               u8* const y, u8* const u, u8* const v) -> void {
+  switch (format) {
+  case PixelFormat::XRGB8888:
+    return convert<PixelFormat::XRGB8888>(pixels, pitch, size, y, u, v);
+  case PixelFormat::ARGB8888:
+    return convert<PixelFormat::ARGB8888>(pixels, pitch, size, y, u, v);
+  case PixelFormat::RGB565:
+    return convert<PixelFormat::RGB565>(pixels, pitch, size, y, u, v);
+  case PixelFormat::BGR24:
+    return convert<PixelFormat::BGR24>(pixels, pitch, size, y, u, v);
+  }
+  // Unreachable.
+  std::terminate();
+}
+
+Recorder::Recorder(std::FILE* const file, uint const framesPerSecond,
+                   bool const blocking)
+    : m_file {file}, m_framesPerSecond {framesPerSecond},
+      m_blocking {blocking} {}
+
+auto Recorder::submit(BackBuffer const& bb) -> bool {
+  Rect<int>::Size const size {static_cast<int>(uint {bb.dimensions.w}),
+                              static_cast<int>(uint {bb.dimensions.h})};
+  auto const rowSize =
+      static_cast<std::size_t>(size.w) * bytes_per_pixel(bb.format);
+
+  // Everything is allocated for the first frame, and later frames only have
+  // to be copied.
+  if (m_slots.empty()) {
+    m_size = size;
+    m_format = bb.format;
+    m_slots.assign(slotCount,
+                   std::vector<u8>(rowSize * static_cast<std::size_t>(size.h)));
+    auto const chromaSize =
+        static_cast<std::size_t>((size.w + 1) / 2 * ((size.h + 1) / 2));
+    m_yuv.resize(static_cast<std::size_t>(size.w * size.h) + chromaSize * 2);
+    m_writer = std::thread {&Recorder::write_frames, this};
+  }
+
+  if (size.w != m_size.w or size.h != m_size.h or bb.format != m_format) {
+    ++m_droppedFrames;
+    return false;
+  }
+
+  std::size_t slot {};
+  {
+    std::unique_lock lock {m_mutex};
+    if (m_blocking) {
+      m_slotFreed.wait(lock, [this] { return m_queued < slotCount; });
+    } else if (m_queued == slotCount) {
+      ++m_droppedFrames;
+      return false;
+    }
+    slot = (m_first + m_queued) % slotCount;
+  }
+
+  // The writer doesn't touch the slot until it's queued.
+  auto* destination = m_slots[slot].data();
+  auto const* source = static_cast<u8 const*>(bb.memory);
+  for (int row {0}; row < size.h; ++row) {
+    std::memcpy(destination, source, rowSize);
+    destination += rowSize;
+    source += uint {bb.pitch};
+  }
+
+  {
+    std::lock_guard lock {m_mutex};
+    ++m_queued;
+  }
+  m_frameQueued.notify_one();
+  return true;
+}
+
+auto Recorder::finish() -> void {
+  {
+    std::lock_guard lock {m_mutex};
+    m_stopping = true;
+  }
+  m_frameQueued.notify_one();
+  if (m_writer.joinable()) {
+    m_writer.join();
+  }
+  std::fflush(m_file);
+}
+
+auto Recorder::write_frames() -> void {
+  std::fprintf(m_file, "YUV4MPEG2 W%d H%d F%u:1 Ip A1:1 C420jpeg\n", m_size.w,
+               m_size.h, m_framesPerSecond);
+
+  auto const lumaSize = static_cast<std::size_t>(m_size.w * m_size.h);
+  auto const chromaSize = (m_yuv.size() - lumaSize) / 2;
+  auto const pitch =
+      static_cast<std::size_t>(m_size.w) * bytes_per_pixel(m_format);
+  while (true) {
+    std::unique_lock lock {m_mutex};
+    m_frameQueued.wait(lock, [this] { return m_queued > 0 or m_stopping; });
+    if (m_queued == 0) {
+      return;
+    }
+    auto const& slot = m_slots[m_first];
+    lock.unlock();
+
+    auto* const y = m_yuv.data();
+    to_yuv420(slot.data(), pitch, m_format, m_size, y, y + lumaSize,
+              y + lumaSize + chromaSize);
+    std::fputs("FRAME\n", m_file);
+    std::fwrite(m_yuv.data(), 1, m_yuv.size(), m_file);
+    ++m_writtenFrames;
+
+    lock.lock();
+    m_first = (m_first + 1) % slotCount;
+    --m_queued;
+    lock.unlock();
+    m_slotFreed.notify_one();
+  }
+}
+
+namespace {
+
+struct FileCloser {
+  auto operator()(std::FILE* const file) const -> void { std::fclose(file); }
+};
+
+struct Recording {
+  std::string path;
+  std::unique_ptr<std::FILE, FileCloser> file;
+  Recorder recorder;
+};
+
+std::unique_ptr<Recording> recording {};
+
+} // namespace
+
+auto start(std::string const& path, bool const blocking) -> bool {
+  std::unique_ptr<std::FILE, FileCloser> file {std::fopen(path.c_str(), "wb")};
+  if (not file) {
+    return false;
+  }
+  auto* const handle = file.get();
+  recording.reset(new Recording {path, std::move(file),
+                                 Recorder {handle, ProgramState::targetFPS,
+                                           blocking}});
+  return true;
+}
+
+auto submit(BackBuffer const& bb) -> void {
+  if (recording) {
+    recording->recorder.submit(bb);
+  }
+}
+
+auto stop() -> void {
+  if (not recording) {
+    return;
+  }
+  recording->recorder.finish();
+  fmt::print("Captured {} frames to {}, dropped {}\n",
+             recording->recorder.written_frames(), recording->path,
+             recording->recorder.dropped_frames());
+  recording.reset();
+}
+
+} // namespace Capture
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "core.hpp"
+#include "util.hpp"
+
+#include "jint.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Records the software renderer's frames as a Y4M video. Finished frames are
+// copied into a fixed ring of slots, and a thread of its own converts and
+// writes them. If it falls behind, new frames are dropped instead of making
+// the game wait, so they're just missing from the video. Recorders that are
+// blocking wait for a free slot instead, for when nobody is watching the
+// frames and they're made as fast as possible, e.g. offscreen.
+namespace Capture {
+
+// Converts the pixels to full range BT.601 YUV with 4:2:0 chroma, i.e. what
+// Y4M calls C420jpeg. The chroma planes are (w + 1) / 2 by (h + 1) / 2.
+auto to_yuv420(u8 const* pixels, std::size_t pitch, PixelFormat format,
+               Rect<int>::Size size, u8* y, u8* u, u8* v) -> void;
+
+class Recorder {
+public:
+  std::size_t static constexpr slotCount {8};
+
+  // The video is as big as the first frame. The file isn't closed.
+  Recorder(std::FILE* file, uint framesPerSecond, bool blocking = false);
+  Recorder(Recorder const&) = delete;
+  auto operator=(Recorder const&) -> Recorder& = delete;
+  ~Recorder() { finish(); }
+
+  // Returns whether the frame was queued. It's dropped if it doesn't match the
+  // first frame, or if every slot is still waiting to be written and the
+  // recorder isn't blocking.
+  auto submit(BackBuffer const& bb) -> bool;
+  // Writes every queued frame and stops the writer.
+  auto finish() -> void;
+
+  // Only valid once finished.
+  [[nodiscard]] auto written_frames() const -> u64 { return m_writtenFrames; }
+  [[nodiscard]] auto dropped_frames() const -> u64 { return m_droppedFrames; }
+
+private:
+  auto write_frames() -> void;
+
+  std::FILE* m_file;
+  uint m_framesPerSecond;
+  bool m_blocking;
+  Rect<int>::Size m_size {};
+  PixelFormat m_format {};
+  std::vector<std::vector<u8>> m_slots {};
+  std::vector<u8> m_yuv {};
+  std::thread m_writer {};
+  u64 m_writtenFrames {0};
+  u64 m_droppedFrames {0};
+
+  std::mutex m_mutex {};
+  std::condition_variable m_frameQueued {};
+  std::condition_variable m_slotFreed {};
+  // Guarded by m_mutex. The slots from m_first on are queued, and the
+  // writer only lets go of the first one once it's written.
+  std::size_t m_first {0};
+  std::size_t m_queued {0};
+  bool m_stopping {false};
+};
+
+// The game's frames are recorded between start() and stop().
+auto start(std::string const& path, bool blocking) -> bool;
+auto submit(BackBuffer const& bb) -> void;
+auto stop() -> void;
+
+} // namespace Capture
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+[[noreturn]] inline auto check_failed(char const* const condition,
+                                      char const* const file, int const line)
+    -> void {
+  std::fprintf(stderr, "%s:%d: Check failed: %s\n", file, line, condition);
+  std::abort();
+}
+
+// Checks a test's condition. Unlike assert() it isn't compiled out of release
+// builds, so the tests check the same things in every build.
+#define CHECK(condition)                                                       \
+  ((condition) ? void(0) : check_failed(#condition, __FILE__, __LINE__))
@@ -2,6 +2,7 @@
 
 #include "draw.hpp"
 #include "input.hpp"
+#include "platform.hpp"
 #include "simulate.hpp"
 #include "tests.hpp"
 
@@ -15,14 +16,30 @@ auto run() -> void {
   MenuState menuState {};
   GameState gameState {menuState.level};
 
+  // Offscreen frames should be the same every run, so they start right in a
+  // game and follow a clock that ticks once per frame instead of real time.
+  auto const offscreen = get_render_mode() == RenderMode::offscreen;
+  if (offscreen) {
+    programState.frameStartClock = {};
+    programState.levelType = ProgramState::LevelType::Game;
+    gameState = GameState {menuState.level, programState.frameStartClock};
+  }
+
   while (programState.running) {
-    auto const newFrameStartClock = std::chrono::high_resolution_clock::now();
-    programState.frameTime = newFrameStartClock - programState.frameStartClock;
-    programState.frameStartClock = newFrameStartClock;
-    if (programState.frameTime < ProgramState::targetFrameTime) {
-      auto const sleepTime =
-          ProgramState::targetFrameTime - programState.frameTime;
-      std::this_thread::sleep_for(sleepTime);
+    if (offscreen) {
+      programState.frameTime = ProgramState::targetFrameTime;
+      programState.frameStartClock += programState.frameTime;
+    } else {
+      auto const newFrameStartClock =
+          std::chrono::high_resolution_clock::now();
+      programState.frameTime =
+          newFrameStartClock - programState.frameStartClock;
+      programState.frameStartClock = newFrameStartClock;
+      if (programState.frameTime < ProgramState::targetFrameTime) {
+        auto const sleepTime =
+            ProgramState::targetFrameTime - programState.frameTime;
+        std::this_thread::sleep_for(sleepTime);
+      }
     }
 
     // input
@@ -2,17 +2,20 @@
 
 #include "board.hpp"
 #include "shape.hpp"
+#include "shape_pool.hpp"
 #include "util.hpp"
 
 #include <array>
 #include <chrono>
 #include <optional>
+#include <type_traits>
 
 struct BackBuffer {
   void* memory {};
   Rect<PositiveUInt>::Size dimensions;
   PositiveUInt pitch {};
   PositiveU8 bpp {};
+  PixelFormat format {PixelFormat::XRGB8888};
 };
 
 auto constexpr gBorderSize = 1;
@@ -30,12 +33,12 @@ auto constexpr gBaseWindowWidth =
 auto constexpr gBaseWindowHeight =
     gBorderSize + gHoldShapeDim.h + gBorderSize + gPlayAreaDim.h + gBorderSize;
 
-ShapePool::DataType static constexpr initialShapes {
-    Shape::Type::I, Shape::Type::L, Shape::Type::J, Shape::Type::O,
-    Shape::Type::S, Shape::Type::Z, Shape::Type::T,
-};
+// Each preview takes up the max height of a shape (2) + 1 for a block of
+// space.
+auto constexpr gPreviewShapeSpacing = 3;
+auto constexpr gPreviewShapeCount = gSidebarDim.h / gPreviewShapeSpacing;
 
-enum class BackToBackType { Tetris, Tspin };
+enum class BackToBackType : u8 { Tetris, Tspin };
 
 auto constexpr gMinLevel = 1;
 auto constexpr gMaxLevel = 99;
@@ -67,11 +70,21 @@ struct ProgramState {
 // i.e. should be reset when starting a new one
 struct GameState {
 
-  explicit GameState(int sstartingLevel) : startingLevel {sstartingLevel} {}
+  using HiResClock = std::chrono::high_resolution_clock;
+
+  // The clocks can be started from any time point, which lets games that are
+  // driven by a deterministic clock (e.g. versus matches) be reproducible.
+  explicit GameState(int sstartingLevel,
+                     HiResClock::time_point const startClock = HiResClock::now(),
+                     Randomizer::Engine::result_type const seed =
+                         ShapePool::defaultSeed)
+      : dropClock {startClock}, startingLevel {sstartingLevel},
+        shapePool {Randomizer::SevenBag {}, seed} {
+    shapePool.generate_ahead(gPreviewShapeCount);
+  }
 
   // unique to current shape
-  using HiResClock = std::chrono::high_resolution_clock;
-  HiResClock::time_point dropClock {HiResClock::now()};
+  HiResClock::time_point dropClock;
   HiResClock::time_point lockClock {dropClock};
   int droppedRows {0};
   int softDropRowCount {0};
@@ -92,15 +105,37 @@ struct GameState {
   // second clear in a row counts as a combo.
   int comboCounter {-1};
   Board board {};
-  ShapePool shapePool {initialShapes};
+  // Always has the previewed shapes generated, so that drawing them doesn't
+  // change the game.
+  ShapePool shapePool {};
   Shape currentShape {shapePool.current_shape()};
   Shape currentShapeShadow {board.get_shadow(currentShape)};
   std::optional<Shape::RotationType> currentRotationType {};
   std::optional<Shape::Type> holdShapeType {};
   bool paused {false};
+  bool gameOver {false};
 
   auto reset() { *this = GameState {startingLevel}; }
 
+  // Visits every field that makes up a game, see snapshot.hpp.
+  template <typename Archive>
+  auto serialize(Archive& archive) -> void {
+    archive(dropClock, lockClock, droppedRows, softDropRowCount,
+            isSoftDropping, linesCleared, startingLevel, level, score, hasHeld,
+            backToBackType, comboCounter, board, shapePool, currentShape,
+            currentShapeShadow, currentRotationType, holdShapeType, paused,
+            gameOver);
+    archive.check(startingLevel >= gMinLevel and
+                  startingLevel <= gMaxLevel and level >= startingLevel);
+    archive.check(linesCleared >= 0 and score >= 0 and comboCounter >= -1);
+    // Only one of the drops is scored when the shape locks.
+    archive.check(droppedRows >= 0 and softDropRowCount >= 0 and
+                  (droppedRows == 0 or softDropRowCount == 0));
+    archive.check(shapePool.generated() > gPreviewShapeCount);
+    archive.check(Board::is_in_bounds(currentShape) and
+                  Board::is_in_bounds(currentShapeShadow));
+  }
+
   [[nodiscard]] auto drop_delay_for_level() const {
     using namespace std::chrono_literals;
     auto const dropDelay = initialDropDelay - (this->level * 100ms);
@@ -109,4 +144,9 @@ struct GameState {
   }
 };
 
+// Rollback and undo save and restore a game by plain copies, so it has to stay
+// a small, trivially copyable value.
+static_assert(std::is_trivially_copyable_v<GameState>);
+static_assert(sizeof(GameState) <= 512);
+
 auto run() -> void;
@@ -0,0 +1,105 @@
+#include "damage.hpp"
+
+namespace Damage {
+
+auto overlapped_tiles(Rect<int> const rect, Rect<int>::Size const frameSize)
+    -> std::optional<Rect<int>> {
+  auto const clipped =
+      rect_intersection(rect, Rect<int> {0, 0, frameSize.w, frameSize.h});
+  if (not clipped) {
+    return std::nullopt;
+  }
+
+  auto const firstColumn = clipped->x / tileSize;
+  auto const endColumn = (clipped->x + clipped->w - 1) / tileSize + 1;
+  auto const firstRow = clipped->y / tileSize;
+  auto const endRow = (clipped->y + clipped->h - 1) / tileSize + 1;
+  return Rect<int> {firstColumn, firstRow, endColumn - firstColumn,
+                    endRow - firstRow};
+}
+
+auto Tracker::begin_frame(Rect<int>::Size const size) -> void {
+  if (size.w != m_size.w or size.h != m_size.h) {
+    m_size = size;
+    m_columns = (size.w + tileSize - 1) / tileSize;
+    m_rows = (size.h + tileSize - 1) / tileSize;
+    m_invalid = true;
+  }
+  auto const tileCount = static_cast<std::size_t>(m_columns * m_rows);
+  m_previousTiles.swap(m_tiles);
+  m_previousTiles.resize(tileCount);
+  m_tiles.assign(tileCount, 0);
+}
+
+auto Tracker::add(Rect<int> const rect, u64 const hash) -> void {
+  auto const tiles = overlapped_tiles(rect, m_size);
+  if (not tiles) {
+    return;
+  }
+
+  for (auto row = tiles->y; row < tiles->y + tiles->h; ++row) {
+    for (auto column = tiles->x; column < tiles->x + tiles->w; ++column) {
+      auto& tile = m_tiles[static_cast<std::size_t>(row * m_columns + column)];
+      tile = mix(tile, hash);
+    }
+  }
+}
+
+auto Tracker::end_frame() -> std::vector<Rect<int>> {
+  std::vector<Rect<int>> damage {};
+  for (int row {0}; row < m_rows; ++row) {
+    auto const rowTiles = static_cast<std::size_t>(row * m_columns);
+    auto const y = row * tileSize;
+    auto const height = std::min(tileSize, m_size.h - y);
+
+    int column {0};
+    while (column < m_columns) {
+      auto const is_damaged = [&](int const c) {
+        auto const i = rowTiles + static_cast<std::size_t>(c);
+        return m_invalid or m_tiles[i] != m_previousTiles[i];
+      };
+      if (not is_damaged(column)) {
+        ++column;
+        continue;
+      }
+
+      auto const firstColumn = column;
+      while (column < m_columns and is_damaged(column)) {
+        ++column;
+      }
+      auto const x = firstColumn * tileSize;
+      auto const endX = std::min(column * tileSize, m_size.w);
+      damage.push_back({x, y, endX - x, height});
+    }
+  }
+
+  m_invalid = false;
+  return damage;
+}
+
+auto merge_vertically(std::vector<Rect<int>> const& rects)
+    -> std::vector<Rect<int>> {
+  std::vector<Rect<int>> merged {};
+  // Only rects ending right above the current row of rects can still grow.
+  std::size_t firstOpen {0};
+  for (auto const& rect : rects) {
+    auto const below = std::find_if(
+        merged.begin() + static_cast<std::ptrdiff_t>(firstOpen), merged.end(),
+        [&rect](Rect<int> const& m) {
+          return m.x == rect.x and m.w == rect.w and m.y + m.h == rect.y;
+        });
+    if (below != merged.end()) {
+      below->h += rect.h;
+      continue;
+    }
+
+    while (firstOpen < merged.size() and
+           merged[firstOpen].y + merged[firstOpen].h < rect.y) {
+      ++firstOpen;
+    }
+    merged.push_back(rect);
+  }
+  return merged;
+}
+
+} // namespace Damage
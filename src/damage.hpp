@@ -0,0 +1,88 @@
+#pragma once
+
+#include "util.hpp"
+
+#include "jint.h"
+
+#include <algorithm>
+#include <optional>
+#include <vector>
+
+// Finds the parts of a frame that changed since the last one. Everything
+// drawn in a frame is described by the rect it covers and a hash of what it
+// draws there, and every tile of the frame keeps a hash of everything drawn
+// over it, in order. Only the tiles whose hash changed need to be redrawn
+// and presented again.
+namespace Damage {
+
+int constexpr tileSize {32};
+
+// Combines a value into a hash. The order values are combined in matters.
+[[nodiscard]] auto constexpr mix(u64 hash, u64 const value) -> u64 {
+  hash ^= value + 0x9e3779b97f4a7c15U + (hash << 6U) + (hash >> 2U);
+  hash ^= hash >> 31U;
+  hash *= 0xbf58476d1ce4e5b9U;
+  return hash ^ (hash >> 27U);
+}
+
+// The columns and rows of the tiles the rect overlaps in a frame of the given
+// size, if it's inside the frame at all.
+[[nodiscard]] auto overlapped_tiles(Rect<int> rect, Rect<int>::Size frameSize)
+    -> std::optional<Rect<int>>;
+
+class Tracker {
+public:
+  // Starts a frame of the given size. If the size changed, all of it is
+  // damaged.
+  auto begin_frame(Rect<int>::Size size) -> void;
+  // Mixes the hash into every tile the rect overlaps.
+  auto add(Rect<int> rect, u64 hash) -> void;
+  // Mixes a hash of only what's drawn in each tile the rect overlaps into it,
+  // for things that are big and often change in just a few places.
+  // `tile_hash` is called with every tile's rect, clipped to the frame.
+  template <typename TileHash>
+  auto add_per_tile(Rect<int> rect, TileHash const& tile_hash) -> void;
+  // Returns the damaged parts of the frame as runs of tiles within each row
+  // of tiles, top to bottom and left to right, clipped to the frame. They
+  // never overlap.
+  [[nodiscard]] auto end_frame() -> std::vector<Rect<int>>;
+  // Damages all of the next frame, e.g. if the pixels of the last one were
+  // lost.
+  auto invalidate() -> void { m_invalid = true; }
+
+private:
+  Rect<int>::Size m_size {};
+  int m_columns {0};
+  int m_rows {0};
+  std::vector<u64> m_tiles {};
+  std::vector<u64> m_previousTiles {};
+  bool m_invalid {true};
+};
+
+template <typename TileHash>
+auto Tracker::add_per_tile(Rect<int> const rect, TileHash const& tile_hash)
+    -> void {
+  auto const tiles = overlapped_tiles(rect, m_size);
+  if (not tiles) {
+    return;
+  }
+
+  for (auto row = tiles->y; row < tiles->y + tiles->h; ++row) {
+    for (auto column = tiles->x; column < tiles->x + tiles->w; ++column) {
+      auto const x = column * tileSize;
+      auto const y = row * tileSize;
+      Rect<int> const tileRect {x, y, std::min(tileSize, m_size.w - x),
+                                std::min(tileSize, m_size.h - y)};
+      auto& tile = m_tiles[static_cast<std::size_t>(row * m_columns + column)];
+      tile = mix(tile, tile_hash(tileRect));
+    }
+  }
+}
+
+// Joins rects that are stacked right on top of each other and span the same
+// columns, e.g. so fewer rects have to be presented. The rects have to be
+// ordered like Tracker::end_frame() orders them.
+[[nodiscard]] auto merge_vertically(std::vector<Rect<int>> const& rects)
+    -> std::vector<Rect<int>>;
+
+} // namespace Damage
@@ -1,8 +1,10 @@
 #include "draw.hpp"
 
+#include "capture.hpp"
 #include "core.hpp"
 #include "draw_opengl.hpp"
 #include "draw_software.hpp"
+#include "draw_terminal.hpp"
 #include "util.hpp"
 
 #include <string_view>
@@ -13,7 +15,9 @@ auto draw_solid_square_normalized(BackBuffer& buf, Rect<double> sqr,
   case RenderMode::opengl: {
     OpenGLRender::draw_solid_square_normalized(sqr, color);
   } break;
-  case RenderMode::software: {
+  case RenderMode::software:
+  case RenderMode::offscreen:
+  case RenderMode::terminal: {
     SoftwareRender::draw_solid_square_normalized(buf, sqr, color);
   } break;
   }
@@ -24,7 +28,9 @@ auto draw_solid_square(BackBuffer& buf, Rect<int> sqr, Color::RGBA color)
   case RenderMode::opengl: {
     OpenGLRender::draw_solid_square(sqr, color);
   } break;
-  case RenderMode::software: {
+  case RenderMode::software:
+  case RenderMode::offscreen:
+  case RenderMode::terminal: {
     SoftwareRender::draw_solid_square(buf, sqr, color);
   } break;
   }
@@ -35,7 +41,9 @@ auto draw_hollow_square(BackBuffer& buf, Rect<int> sqr, Color::RGBA color,
   case RenderMode::opengl: {
     OpenGLRender::draw_hollow_square(buf, sqr, color, borderSize);
   } break;
-  case RenderMode::software: {
+  case RenderMode::software:
+  case RenderMode::offscreen:
+  case RenderMode::terminal: {
     SoftwareRender::draw_hollow_square(buf, sqr, color, borderSize);
   } break;
   }
@@ -46,7 +54,9 @@ auto draw_hollow_square_normalized(BackBuffer& buf, Rect<double> sqr,
   case RenderMode::opengl: {
     OpenGLRender::draw_hollow_square_normalized(buf, sqr, color, borderSize);
   } break;
-  case RenderMode::software: {
+  case RenderMode::software:
+  case RenderMode::offscreen:
+  case RenderMode::terminal: {
     SoftwareRender::draw_hollow_square_normalized(buf, sqr, color, borderSize);
   } break;
   }
@@ -57,9 +67,13 @@ auto draw_font_string(BackBuffer& buf, FontString const& fontString,
   case RenderMode::opengl: {
     OpenGLRender::draw_font_string(buf, fontString, coords);
   } break;
-  case RenderMode::software: {
+  case RenderMode::software:
+  case RenderMode::offscreen: {
     SoftwareRender::draw_font_string(buf, fontString, coords);
   } break;
+  case RenderMode::terminal: {
+    TerminalRender::draw_font_string(buf, fontString, coords);
+  } break;
   }
 }
 auto draw_font_string_normalized(BackBuffer& buf, FontString const& fontString,
@@ -68,10 +82,15 @@ auto draw_font_string_normalized(BackBuffer& buf, FontString const& fontString,
   case RenderMode::opengl: {
     OpenGLRender::draw_font_string_normalized(buf, fontString, relativeCoords);
   } break;
-  case RenderMode::software: {
+  case RenderMode::software:
+  case RenderMode::offscreen: {
     SoftwareRender::draw_font_string_normalized(buf, fontString,
                                                 relativeCoords);
   } break;
+  case RenderMode::terminal: {
+    TerminalRender::draw_font_string_normalized(buf, fontString,
+                                                relativeCoords);
+  } break;
   }
 }
 auto draw_text(BackBuffer& buf, std::string_view text, Point<int> coords,
@@ -80,9 +99,13 @@ auto draw_text(BackBuffer& buf, std::string_view text, Point<int> coords,
   case RenderMode::opengl: {
     OpenGLRender::draw_text(buf, text, coords, pixelHeight);
   } break;
-  case RenderMode::software: {
+  case RenderMode::software:
+  case RenderMode::offscreen: {
     SoftwareRender::draw_text(buf, text, coords, pixelHeight);
   } break;
+  case RenderMode::terminal: {
+    TerminalRender::draw_text(buf, text, coords, pixelHeight);
+  } break;
   }
 }
 auto draw_text_normalized(BackBuffer& buf, std::string_view text,
@@ -92,22 +115,32 @@ auto draw_text_normalized(BackBuffer& buf, std::string_view text,
   case RenderMode::opengl: {
     OpenGLRender::draw_text_normalized(buf, text, relativeCoords, pixelHeight);
   } break;
-  case RenderMode::software: {
+  case RenderMode::software:
+  case RenderMode::offscreen: {
     SoftwareRender::draw_text_normalized(buf, text, relativeCoords,
                                          pixelHeight);
   } break;
+  case RenderMode::terminal: {
+    TerminalRender::draw_text_normalized(buf, text, relativeCoords,
+                                         pixelHeight);
+  } break;
   }
 }
 
-auto draw(ProgramState& programState, GameState& gameState) -> void {
+auto draw(ProgramState& programState, GameState const& gameState) -> void {
   switch (get_render_mode()) {
   case RenderMode::opengl: {
     OpenGLRender::draw(programState, gameState);
+    swap_buffer();
   } break;
-  case RenderMode::software: {
-    SoftwareRender::draw(programState, gameState);
+  case RenderMode::software:
+  case RenderMode::offscreen: {
+    auto const damagedRects = SoftwareRender::draw(programState, gameState);
+    Capture::submit(get_back_buffer());
+    swap_buffer(damagedRects);
+  } break;
+  case RenderMode::terminal: {
+    present_terminal_frame(TerminalRender::draw(programState, gameState));
   } break;
   }
-
-  swap_buffer();
 }
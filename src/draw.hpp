@@ -38,7 +38,7 @@
   return width * get_window_dimensions().w;
 }
 
-auto draw(ProgramState& programState, GameState& gameState) -> void;
+auto draw(ProgramState& programState, GameState const& gameState) -> void;
 
 auto draw_solid_square_normalized(BackBuffer& buf, Rect<double> sqr,
                                   Color::RGBA color) -> void;
@@ -3,16 +3,206 @@
 #include "core.hpp"
 #include "draw.hpp"
 #include "platform.hpp"
+#include "ui.hpp"
 
 #include "glad/glad.h"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtc/type_ptr.hpp"
 #include "glm/mat4x4.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
 #include <utility>
+#include <vector>
+
+// Buffer storage is only in the headers of GL 4.4 and later.
+#if not defined(GL_MAP_PERSISTENT_BIT)
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#if not defined(GL_MAP_COHERENT_BIT)
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
 
 namespace OpenGLRender {
 
+// A solid rect in normalized coordinates and its color, as the solid shader
+// reads them for every instance.
+struct SolidInstance {
+  GLfloat x;
+  GLfloat y;
+  GLfloat w;
+  GLfloat h;
+  std::array<GLubyte, 4> color;
+};
+static_assert(sizeof(SolidInstance) == 5 * sizeof(GLfloat));
+
+// Every solid rect of the frame, in the order they're drawn.
+std::vector<SolidInstance> solidInstances;
+
+// A corner of a character's quad in normalized coordinates, and where it is
+// in the baked characters' bitmap.
+struct TextVertex {
+  GLfloat x;
+  GLfloat y;
+  GLfloat u;
+  GLfloat v;
+};
+
+// The quads of every character of the frame, in pixels.
+std::vector<stbtt_aligned_quad> textQuads;
+
+// Points the solid shader's per instance attributes at the rects that start
+// `offset` bytes into the buffer bound to GL_ARRAY_BUFFER.
+auto static point_solid_instances_at(std::size_t const offset) -> void {
+  glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(SolidInstance),
+                        reinterpret_cast<GLvoid*>(offset));
+  glVertexAttribPointer(
+      2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SolidInstance),
+      reinterpret_cast<GLvoid*>(offset + offsetof(SolidInstance, color)));
+}
+
+using BufferStorageProc = void(APIENTRY*)(GLenum target, GLsizeiptr size,
+                                          void const* data, GLbitfield flags);
+
+// glad only loads GL 3.3, so glBufferStorage is looked up by hand. Returns
+// null if neither the context's version nor its extensions have it.
+auto static load_buffer_storage() -> BufferStorageProc {
+  GLint major {0};
+  GLint minor {0};
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+  auto supported = major > 4 or (major == 4 and minor >= 4);
+
+  GLint extensionCount {0};
+  glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+  for (GLint i {0}; not supported and i < extensionCount; ++i) {
+    auto const* const extension = reinterpret_cast<char const*>(
+        glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+    supported = std::strcmp(extension, "GL_ARB_buffer_storage") == 0;
+  }
+
+  if (not supported) {
+    return nullptr;
+  }
+  return reinterpret_cast<BufferStorageProc>(
+      get_opengl_proc_address("glBufferStorage"));
+}
+
+StreamBuffer::StreamBuffer(std::size_t const regionSize)
+    : m_regionSize {regionSize} {
+  glGenBuffers(1, &m_handle);
+  glBindBuffer(GL_ARRAY_BUFFER, m_handle);
+
+  if (auto const buffer_storage = load_buffer_storage()) {
+    auto const size = static_cast<GLsizeiptr>(m_regionSize * regionCount);
+    auto constexpr flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    buffer_storage(GL_ARRAY_BUFFER, size, nullptr, flags);
+    m_mapped = static_cast<std::byte*>(
+        glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+    if (not m_mapped) {
+      // The storage can't be respecified, so the fallback needs a new buffer.
+      glDeleteBuffers(1, &m_handle);
+      glGenBuffers(1, &m_handle);
+      glBindBuffer(GL_ARRAY_BUFFER, m_handle);
+    }
+  }
+
+  // Without a mapping there's only ever the one region, which is orphaned
+  // every frame.
+  if (not m_mapped) {
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_regionSize),
+                 nullptr, GL_STREAM_DRAW);
+  }
+}
+
+StreamBuffer::StreamBuffer(StreamBuffer&& other) noexcept
+    : m_handle {std::exchange(other.m_handle, 0)},
+      m_regionSize {other.m_regionSize},
+      m_mapped {std::exchange(other.m_mapped, nullptr)},
+      m_fences {std::exchange(other.m_fences, {})},
+      m_region {other.m_region}, m_used {other.m_used} {}
+
+auto StreamBuffer::operator=(StreamBuffer&& other) noexcept -> StreamBuffer& {
+  std::swap(m_handle, other.m_handle);
+  std::swap(m_regionSize, other.m_regionSize);
+  std::swap(m_mapped, other.m_mapped);
+  std::swap(m_fences, other.m_fences);
+  std::swap(m_region, other.m_region);
+  std::swap(m_used, other.m_used);
+  return *this;
+}
+
+auto StreamBuffer::release() -> void {
+  for (auto& fence : m_fences) {
+    glDeleteSync(std::exchange(fence, nullptr));
+  }
+  if (m_handle == 0) {
+    return;
+  }
+  if (m_mapped) {
+    glBindBuffer(GL_ARRAY_BUFFER, m_handle);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    m_mapped = nullptr;
+  }
+  glDeleteBuffers(1, &m_handle);
+  m_handle = 0;
+}
+
+auto StreamBuffer::write(gsl::span<std::byte const> const bytes)
+    -> std::optional<std::size_t> {
+  auto const size = static_cast<std::size_t>(bytes.size());
+  if (size > m_regionSize - m_used) {
+    return std::nullopt;
+  }
+
+  std::size_t offset {m_used};
+  if (m_mapped) {
+    // The first write to a region has to wait until the GPU is done with the
+    // frame that used it last, which is usually long ago.
+    auto& fence = m_fences[m_region];
+    if (fence) {
+      auto constexpr timeout = GLuint64 {1'000'000'000};
+      GLenum status {GL_TIMEOUT_EXPIRED};
+      while (status == GL_TIMEOUT_EXPIRED) {
+        status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+      }
+      glDeleteSync(std::exchange(fence, nullptr));
+    }
+    offset += m_region * m_regionSize;
+    std::memcpy(m_mapped + offset, bytes.data(), size);
+  } else {
+    glBindBuffer(GL_ARRAY_BUFFER, m_handle);
+    if (m_used == 0) {
+      glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_regionSize),
+                   nullptr, GL_STREAM_DRAW);
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(offset),
+                    static_cast<GLsizeiptr>(size), bytes.data());
+  }
+
+  // Every write starts suitably aligned for any vertex attribute.
+  auto constexpr alignment = std::size_t {16};
+  m_used = std::min(m_regionSize, m_used + (size + alignment - 1) /
+                                               alignment * alignment);
+  return offset;
+}
+
+auto StreamBuffer::end_frame() -> void {
+  if (m_used == 0) {
+    return;
+  }
+  if (m_mapped) {
+    m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_region = (m_region + 1) % regionCount;
+  }
+  m_used = 0;
+}
+
 Shader::Shader(GLenum shaderType, GLchar const* src) {
   auto shaderHandle = glCreateShader(shaderType);
   glShaderSource(shaderHandle, 1, &src, nullptr);
@@ -23,7 +213,7 @@ Shader::Shader(GLenum shaderType, GLchar const* src) {
     if (success == 0) {
       char infoLog[512];
       glGetShaderInfoLog(shaderHandle, 512, nullptr, infoLog);
-      throw std::exception(infoLog);
+      throw std::runtime_error(infoLog);
     }
   }
   m_handle = shaderHandle;
@@ -44,7 +234,7 @@ Shader::Program::Program(GLchar const* vertexSource,
     if (success == 0) {
       char infoLog[512];
       glGetProgramInfoLog(programHandle, 512, nullptr, infoLog);
-      throw std::exception(infoLog);
+      throw std::runtime_error(infoLog);
     }
   }
 
@@ -81,6 +271,15 @@ Context::Context() {
     // provide 3 floats to vertex shader??
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
     glEnableVertexAttribArray(0);
+
+    // The rects are written to the stream buffer every frame, and the
+    // attributes are pointed at wherever they ended up.
+    glBindBuffer(GL_ARRAY_BUFFER, m_stream.handle());
+    point_solid_instances_at(0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
   }
 
   // Set up the rainbow shader's vbo, vao, and ebo.
@@ -123,35 +322,85 @@ Context::Context() {
   {
     auto const& bakedCharsBitmap = get_baked_chars_bitmap();
 
+    // The core profile doesn't have alpha textures, so the coverage goes in
+    // the red channel.
     glGenTextures(1, &m_fontTexture);
     glBindTexture(GL_TEXTURE_2D, m_fontTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, bakedCharsBitmap.w,
-                 bakedCharsBitmap.h, 0, GL_ALPHA, GL_UNSIGNED_BYTE,
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, bakedCharsBitmap.w,
+                 bakedCharsBitmap.h, 0, GL_RED, GL_UNSIGNED_BYTE,
                  bakedCharsBitmap.bitmap.data());
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
     glGenVertexArrays(1, &m_fontShaderVAO);
-    glGenBuffers(1, &m_fontShaderVBO);
 
     glBindVertexArray(m_fontShaderVAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_fontShaderVBO);
-    // the vertex- and texture data gets filled in every time a character is
-    // drawn, so there's no need for them here.
-    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 4, nullptr,
-                 GL_DYNAMIC_DRAW);
-
+    // The vertex and texture data is written to the stream buffer whenever
+    // text is drawn.
+    glBindBuffer(GL_ARRAY_BUFFER, m_stream.handle());
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat),
                           nullptr);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
   }
+
+  // Set up the board shader's vao, texture, and palette
+  {
+    glGenVertexArrays(1, &m_boardShaderVAO);
+
+    // Integer textures can't be filtered, and a cell is always a whole
+    // texel anyway. The cells are filled in on the first frame.
+    glGenTextures(1, &m_boardTexture);
+    glBindTexture(GL_TEXTURE_2D, m_boardTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, Board::columns,
+                 Board::visibleRows, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE,
+                 nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    static_assert(static_cast<u8>(Block::Kind::Garbage) == 8,
+                  "The board shader's palette has a color for every kind");
+    std::vector<GLColor> palette {};
+    for (u8 kind {0}; kind <= static_cast<u8>(Block::Kind::Garbage); ++kind) {
+      palette.emplace_back(Block {static_cast<Block::Kind>(kind)}.color());
+    }
+    m_board.use();
+    m_board.set_vec4s(Shader::Uniform::palette, palette);
+  }
+}
+
+auto Context::update_board_texture(Board const& board) -> void {
+  auto constexpr hiddenRows = Board::rows - Board::visibleRows;
+  auto const* const cells = &board.block_at(hiddenRows * Board::columns);
+  auto const same_kind = [](Block const lhs, Block const rhs) {
+    return lhs.kind == rhs.kind;
+  };
+  if (m_boardCells and std::equal(m_boardCells->begin(), m_boardCells->end(),
+                                  cells, same_kind)) {
+    return;
+  }
+
+  m_boardCells.emplace();
+  std::copy_n(cells, m_boardCells->size(), m_boardCells->begin());
+  // A block is just the kind of block, so the cells are uploaded as is.
+  glBindTexture(GL_TEXTURE_2D, m_boardTexture);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, Board::columns, Board::visibleRows,
+                  GL_RED_INTEGER, GL_UNSIGNED_BYTE, m_boardCells->data());
 }
 
 Context::Context(Context&& other) noexcept
-    : m_solid {std::move(other.m_solid)}, m_rainbow {
-                                              std::move(other.m_rainbow)} {
+    : m_solid {std::move(other.m_solid)},
+      m_rainbow {std::move(other.m_rainbow)},
+      m_font {std::move(other.m_font)},
+      m_board {std::move(other.m_board)},
+      m_boardCells {std::move(other.m_boardCells)},
+      m_stream {std::move(other.m_stream)} {
   delete_solid_shader_buffers();
   m_solidShaderEBO = std::exchange(other.m_solidShaderEBO, 0);
   m_solidShaderVAO = std::exchange(other.m_solidShaderVAO, 0);
@@ -164,7 +413,11 @@ Context::Context(Context&& other) noexcept
 
   delete_font_shader_buffers();
   m_fontShaderVAO = std::exchange(other.m_fontShaderVAO, 0);
-  m_fontShaderVBO = std::exchange(other.m_fontShaderVBO, 0);
+  m_fontTexture = std::exchange(other.m_fontTexture, 0);
+
+  delete_board_shader_buffers();
+  m_boardShaderVAO = std::exchange(other.m_boardShaderVAO, 0);
+  m_boardTexture = std::exchange(other.m_boardTexture, 0);
 }
 
 auto Context::operator=(Context&& other) noexcept -> Context& {
@@ -185,22 +438,22 @@ auto Context::operator=(Context&& other) noexcept -> Context& {
   m_rainbowShaderVBO = std::exchange(other.m_rainbowShaderVBO, 0);
 
   delete_font_shader_buffers();
+  m_font = std::move(other.m_font);
   m_fontShaderVAO = std::exchange(other.m_fontShaderVAO, 0);
-  m_fontShaderVBO = std::exchange(other.m_fontShaderVBO, 0);
+  m_fontTexture = std::exchange(other.m_fontTexture, 0);
 
-  return *this;
-}
+  delete_board_shader_buffers();
+  m_board = std::move(other.m_board);
+  m_boardShaderVAO = std::exchange(other.m_boardShaderVAO, 0);
+  m_boardTexture = std::exchange(other.m_boardTexture, 0);
+  m_boardCells = std::move(other.m_boardCells);
 
-struct DrawObject {
-  GLuint vao;
-  Shader::Program const& shaderProgram;
-  Color::RGBA color;
-  Rect<double> rect;
-};
+  m_stream = std::move(other.m_stream);
 
-std::vector<DrawObject> drawObjects;
+  return *this;
+}
 
-auto draw(ProgramState& programState, GameState& gameState) -> void {
+auto draw(ProgramState& programState, GameState const& gameState) -> void {
   glClearColor(0.2F, 0.3F, 0.3F, 1.0F);
   glClear(GL_COLOR_BUFFER_BIT);
 
@@ -218,32 +471,30 @@ auto draw(ProgramState& programState, GameState& gameState) -> void {
   case ProgramState::LevelType::Menu: {
   } break;
   case ProgramState::LevelType::Game: {
-    // draw playarea
+    // draw playarea, with the board's cells filled in by the board shader
     {
-      auto const& solidShader = get_opengl_render_context().solid_shader();
-      solidShader.use();
-      solidShader.set_vec4(Shader::Uniform::color, GLColor {Color::black});
-
-      {
-        glm::mat4 model {1};
-        auto const scale = get_window_scale();
-        auto const normalizedPlayArea = to_normalized({
-            static_cast<double>(gPlayAreaDim.x) * scale,
-            static_cast<double>(gPlayAreaDim.y) * scale,
-            static_cast<double>(gPlayAreaDim.w) * scale,
-            static_cast<double>(gPlayAreaDim.h) * scale,
-        });
-        model = glm::translate(
-            model, glm::vec3 {normalizedPlayArea.x, normalizedPlayArea.y, 0.F});
-        model = glm::scale(
-            model, glm::vec3 {normalizedPlayArea.w, normalizedPlayArea.h, 0.F});
-        solidShader.set_matrix4(Shader::Uniform::model, model);
-      }
-
-      solidShader.set_matrix4(Shader::Uniform::projection, orthoProjection);
-
-      glBindVertexArray(get_opengl_render_context().solid_shader_vao());
-      glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+      auto& context = get_opengl_render_context();
+      context.update_board_texture(gameState.board);
+
+      auto const playAreaDim = gPlayAreaDim * get_window_scale();
+      auto const playArea = to_normalized({
+          static_cast<double>(playAreaDim.x),
+          static_cast<double>(playAreaDim.y),
+          static_cast<double>(playAreaDim.w),
+          static_cast<double>(playAreaDim.h),
+      });
+      auto const& boardShader = context.board_shader();
+      boardShader.use();
+      boardShader.set_matrix4(Shader::Uniform::projection, orthoProjection);
+      boardShader.set_vec4(Shader::Uniform::rect,
+                           static_cast<float>(playArea.x),
+                           static_cast<float>(playArea.y),
+                           static_cast<float>(playArea.w),
+                           static_cast<float>(playArea.h));
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D, context.board_texture());
+      glBindVertexArray(context.board_shader_vao());
+      glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
     }
 
     auto draw_shape_in_play_area = [](Shape const& shape) {
@@ -265,44 +516,24 @@ auto draw(ProgramState& programState, GameState& gameState) -> void {
       }
     };
 
-    for (std::size_t y = 2; y < Board::rows; ++y) {
-      for (std::size_t x = 0; x < Board::columns; ++x) {
-        auto const currIndex =
-            gsl::narrow_cast<gsl::index>(y * Board::columns + x);
-        auto const& block = gameState.board.block_at(currIndex);
-        if (not block.isActive) {
-          continue;
-        }
-
-        auto const scale = static_cast<std::size_t>(get_window_scale());
-
-        Rect<int> square {static_cast<int>((x + gPlayAreaDim.x) * scale),
-                          static_cast<int>((y - 2 + gPlayAreaDim.y) * scale),
-                          static_cast<int>(scale), static_cast<int>(scale)};
-        draw_solid_square(square, block.color);
-      }
-    }
-
-    draw_shape_in_play_area(gameState.currentShape);
-    // FIXME: the shadow doesn't seem to be transparent?
+    // The shadow is translucent, so it goes under the shape where they
+    // overlap, like in the software renderer.
     draw_shape_in_play_area(gameState.currentShapeShadow);
+    draw_shape_in_play_area(gameState.currentShape);
 
     // draw shape previews
     {
       auto const scale = get_window_scale();
-      auto const previewArray = gameState.shapePool.get_preview_shapes_array();
-      int i {0};
-      for (auto const shapeType : previewArray) {
-        Shape shape {shapeType};
+      for (int i {0}; i < gPreviewShapeCount; ++i) {
+        Shape shape {
+            gameState.shapePool.peek(static_cast<std::size_t>(i) + 1)};
         shape.pos.x = gSidebarDim.x;
-        int const ySpacing {3};
-        shape.pos.y = gSidebarDim.y + ySpacing * i;
+        shape.pos.y = gSidebarDim.y + gPreviewShapeSpacing * i;
         for (auto const& position : shape.get_absolute_block_positions()) {
           Rect<int> square {position.x * scale, position.y * scale, scale,
                             scale};
           draw_solid_square(square, shape.color);
         }
-        ++i;
       }
     }
 
@@ -337,44 +568,87 @@ auto draw(ProgramState& programState, GameState& gameState) -> void {
   } break;
   }
 
-  for (auto object : drawObjects) {
-    object.shaderProgram.use();
-    object.shaderProgram.set_vec4(Shader::Uniform::color,
-                                  GLColor {object.color});
-
-    {
-      glm::mat4 model {1};
-      model =
-          glm::translate(model, glm::vec3 {object.rect.x, object.rect.y, 0.F});
-      model = glm::scale(model, glm::vec3 {object.rect.w, object.rect.h, 0.F});
-      object.shaderProgram.set_matrix4(Shader::Uniform::model, model);
-    }
-
-    object.shaderProgram.set_matrix4(Shader::Uniform::projection,
-                                     orthoProjection);
+  // The UI's drawing functions don't need a back buffer in OpenGL mode.
+  UI::draw(BackBuffer {});
+
+  auto& context = get_opengl_render_context();
+  auto& stream = context.stream_buffer();
+
+  // Every solid rect is drawn with a single draw call, in the order they
+  // were added. A frame can't have anywhere near enough of them to fill up
+  // the stream buffer.
+  auto const solidOffset =
+      solidInstances.empty()
+          ? std::nullopt
+          : stream.write(gsl::as_bytes(gsl::make_span(solidInstances)));
+  if (solidOffset) {
+    auto const& solidShader = context.solid_shader();
+    solidShader.use();
+    solidShader.set_matrix4(Shader::Uniform::projection, orthoProjection);
+
+    glBindVertexArray(context.solid_shader_vao());
+    glBindBuffer(GL_ARRAY_BUFFER, stream.handle());
+    point_solid_instances_at(*solidOffset);
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr,
+                            static_cast<GLsizei>(solidInstances.size()));
+  }
 
-    glBindVertexArray(object.vao);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+  // Every character is drawn with a single draw call as well, on top of
+  // the rects.
+  static std::vector<TextVertex> textVertices {};
+  textVertices.clear();
+  auto const windowDimensions = get_window_dimensions();
+  auto const width = static_cast<GLfloat>(windowDimensions.w);
+  auto const height = static_cast<GLfloat>(windowDimensions.h);
+  for (auto const& quad : textQuads) {
+    TextVertex const topLeft {quad.x0 / width, quad.y0 / height, quad.s0,
+                              quad.t0};
+    TextVertex const topRight {quad.x1 / width, quad.y0 / height, quad.s1,
+                               quad.t0};
+    TextVertex const bottomLeft {quad.x0 / width, quad.y1 / height, quad.s0,
+                                 quad.t1};
+    TextVertex const bottomRight {quad.x1 / width, quad.y1 / height,
+                                  quad.s1, quad.t1};
+    textVertices.insert(textVertices.end(), {topLeft, topRight, bottomRight,
+                                             topLeft, bottomLeft,
+                                             bottomRight});
+  }
+  auto const textOffset =
+      textVertices.empty()
+          ? std::nullopt
+          : stream.write(gsl::as_bytes(gsl::make_span(textVertices)));
+  if (textOffset) {
+    auto const& fontShader = context.font_shader();
+    fontShader.use();
+    fontShader.set_matrix4(Shader::Uniform::projection, orthoProjection);
+    fontShader.set_vec4(Shader::Uniform::color, GLColor {Color::black});
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, context.font_texture());
+    glBindVertexArray(context.font_shader_vao());
+    glBindBuffer(GL_ARRAY_BUFFER, stream.handle());
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(TextVertex),
+                          reinterpret_cast<GLvoid*>(*textOffset));
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(textVertices.size()));
   }
 
   glBindVertexArray(0);
+  stream.end_frame();
 
-  drawObjects.clear();
+  solidInstances.clear();
+  textQuads.clear();
 }
 
 auto draw_solid_square_normalized(Rect<double> sqr, Color::RGBA color) -> void {
-  // FIXME: probably need to flip the image upside down since opengl counts
-  //        0,0 as bottom left corner while we count 0,0 as top left.
-
-  auto const& renderContext = get_opengl_render_context();
-  auto const& shaderProgram = renderContext.solid_shader();
-
-  drawObjects.push_back(
-      {renderContext.solid_shader_vao(), shaderProgram, color, sqr});
+  solidInstances.push_back({static_cast<GLfloat>(sqr.x),
+                            static_cast<GLfloat>(sqr.y),
+                            static_cast<GLfloat>(sqr.w),
+                            static_cast<GLfloat>(sqr.h),
+                            {u8 {color.r}, u8 {color.g}, u8 {color.b},
+                             u8 {color.a}}});
 }
 
 auto draw_solid_square(Rect<int> sqr, Color::RGBA color) -> void {
-  auto const& renderContext = get_opengl_render_context();
   auto normalized = to_normalized({
       static_cast<double>(sqr.x),
       static_cast<double>(sqr.y),
@@ -383,18 +657,82 @@ auto draw_solid_square(Rect<int> sqr, Color::RGBA color) -> void {
   });
   draw_solid_square_normalized(normalized, color);
 }
-auto draw_hollow_square(BackBuffer& buf, Rect<int> sqr, Color::RGBA color,
-                        int borderSize) -> void {}
-auto draw_hollow_square_normalized(BackBuffer& buf, Rect<double> sqr,
-                                   Color::RGBA color, int borderSize) -> void {}
-auto draw_font_string(BackBuffer& buf, FontString const& fontString,
-                      Point<int> coords) -> void {}
+
+// The back buffers are only there to match the software renderer's functions.
+auto draw_hollow_square(BackBuffer& /*buf*/, Rect<int> const sqr,
+                        Color::RGBA const color, int const borderSize)
+    -> void {
+  if (sqr.w <= 0 or sqr.h <= 0) {
+    return;
+  }
+
+  // Like in the software renderer, the sides don't overlap, so translucent
+  // borders aren't blended twice in the corners.
+  auto const top = std::clamp(borderSize, 0, sqr.h);
+  auto const bottom = std::clamp(borderSize, 0, sqr.h - top);
+  auto const left = std::clamp(borderSize, 0, sqr.w);
+  auto const right = std::clamp(borderSize, 0, sqr.w - left);
+  auto const middleHeight = sqr.h - top - bottom;
+
+  draw_solid_square({sqr.x, sqr.y, sqr.w, top}, color);
+  draw_solid_square({sqr.x, sqr.y + sqr.h - bottom, sqr.w, bottom}, color);
+  draw_solid_square({sqr.x, sqr.y + top, left, middleHeight}, color);
+  draw_solid_square({sqr.x + sqr.w - right, sqr.y + top, right, middleHeight},
+                    color);
+}
+
+auto draw_hollow_square_normalized(BackBuffer& buf, Rect<double> const sqr,
+                                   Color::RGBA const color,
+                                   int const borderSize) -> void {
+  auto const screenSpace = to_screen_space(sqr);
+  Rect<int> const newSqr {static_cast<int>(screenSpace.x),
+                          static_cast<int>(screenSpace.y),
+                          static_cast<int>(screenSpace.w),
+                          static_cast<int>(screenSpace.h)};
+  OpenGLRender::draw_hollow_square(buf, newSqr, color, borderSize);
+}
+
+auto draw_font_string(BackBuffer& /*buf*/, FontString const& fontString,
+                      Point<int> const coords) -> void {
+  std::string text(fontString.data.size(), '\0');
+  std::transform(fontString.data.begin(), fontString.data.end(),
+                 text.begin(), [](auto const& fontCharacter) {
+                   return fontCharacter.character;
+                 });
+  append_baked_quads(text, fontString.pixelHeight,
+                     {static_cast<double>(coords.x),
+                      static_cast<double>(coords.y)},
+                     textQuads);
+}
+
 auto draw_font_string_normalized(BackBuffer& buf, FontString const& fontString,
-                                 Point<double> relativeCoords) -> void {}
-auto draw_text(BackBuffer& buf, std::string_view text, Point<int> coords,
-               double pixelHeight) -> void {}
-auto draw_text_normalized(BackBuffer& buf, std::string_view text,
-                          Point<double> relativeCoords, double pixelHeight)
-    -> void {}
+                                 Point<double> const relativeCoords) -> void {
+  Point<int> const realCoords {
+      static_cast<int>(to_screen_space_width(relativeCoords.x)),
+      static_cast<int>(to_screen_space_height(relativeCoords.y)),
+  };
+  OpenGLRender::draw_font_string(buf, fontString, realCoords);
+}
+
+// Text is laid out from the baked characters right away, instead of
+// rasterizing every character like a FontString does.
+auto draw_text(BackBuffer& /*buf*/, std::string_view const text,
+               Point<int> const coords, double const pixelHeight) -> void {
+  append_baked_quads(
+      text, pixelHeight,
+      {static_cast<double>(coords.x), static_cast<double>(coords.y)},
+      textQuads);
+}
+
+auto draw_text_normalized(BackBuffer& buf, std::string_view const text,
+                          Point<double> const relativeCoords,
+                          double const pixelHeight) -> void {
+  Point<int> const realCoords {
+      static_cast<int>(to_screen_space_width(relativeCoords.x)),
+      static_cast<int>(to_screen_space_height(relativeCoords.y)),
+  };
+  OpenGLRender::draw_text(buf, text, realCoords,
+                          to_screen_space_height(pixelHeight));
+}
 
 } // namespace OpenGLRender
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "board.hpp"
 #include "core.hpp"
 #include "font.hpp"
 #include "util.hpp"
@@ -8,7 +9,12 @@
 #include "glm/gtc/type_ptr.hpp"
 #include "glm/mat4x4.hpp"
 
+#include <gsl/gsl>
+
+#include <array>
+#include <cstddef>
 #include <exception>
+#include <optional>
 #include <utility>
 
 namespace OpenGLRender {
@@ -51,18 +57,21 @@ public:
 
   enum class Uniform {
     color,
-    model,
     projection,
+    rect,
+    palette,
   };
 
   auto static constexpr to_string_view(Uniform const u) -> std::string_view {
     switch (u) {
     case Uniform::color:
       return "color";
-    case Uniform::model:
-      return "model";
     case Uniform::projection:
       return "projection";
+    case Uniform::rect:
+      return "rect";
+    case Uniform::palette:
+      return "palette";
     }
     // Unreachable.
     std::terminate();
@@ -116,6 +125,14 @@ public:
       glUniform4f(uniformLoc, r, g, b, a);
     }
 
+    auto set_vec4s(Uniform u, gsl::span<GLColor const> const colors) const
+        -> void {
+      auto const name = to_string_view(u);
+      auto uniformLoc = glGetUniformLocation(m_handle, name.data());
+      glUniform4fv(uniformLoc, static_cast<GLsizei>(colors.size()),
+                   &colors.data()->r);
+    }
+
   private:
     GLuint m_handle {0};
   };
@@ -124,6 +141,49 @@ private:
   GLuint m_handle {0};
 };
 
+// A big vertex buffer that the geometry which changes every frame is written
+// into, so it never has to wait for the GPU to be done with the last frame's.
+// Where buffer storage is supported (GL 4.4 or ARB_buffer_storage), it's
+// mapped once for good and split into a region for every frame in flight,
+// each with a fence that tells when the GPU is done reading it. Otherwise the
+// buffer is orphaned at the start of every frame, so the driver hands out
+// fresh memory instead of waiting.
+class StreamBuffer {
+public:
+  std::size_t static constexpr regionCount {3};
+  std::size_t static constexpr defaultRegionSize {1 << 20};
+
+  explicit StreamBuffer(std::size_t regionSize = defaultRegionSize);
+  StreamBuffer(StreamBuffer const&) = delete;
+  auto operator=(StreamBuffer const&) = delete;
+  StreamBuffer(StreamBuffer&& other) noexcept;
+  auto operator=(StreamBuffer&& other) noexcept -> StreamBuffer&;
+  ~StreamBuffer() { release(); }
+
+  // Copies the bytes into the frame's region and returns where they start in
+  // the buffer, or nothing if the region is full.
+  [[nodiscard]] auto write(gsl::span<std::byte const> bytes)
+      -> std::optional<std::size_t>;
+  // Has to be called once all of the frame's draws using the buffer have
+  // been issued.
+  auto end_frame() -> void;
+
+  [[nodiscard]] auto handle() const -> GLuint { return m_handle; }
+  [[nodiscard]] auto is_persistent() const -> bool { return m_mapped; }
+
+private:
+  auto release() -> void;
+
+  GLuint m_handle {0};
+  std::size_t m_regionSize {0};
+  // Where the buffer is mapped, if it's persistent.
+  std::byte* m_mapped {nullptr};
+  std::array<GLsync, regionCount> m_fences {};
+  std::size_t m_region {0};
+  // How much of the frame's region has been written.
+  std::size_t m_used {0};
+};
+
 class Context {
 public:
   Context();
@@ -135,6 +195,7 @@ public:
     delete_solid_shader_buffers();
     delete_rainbow_shader_buffers();
     delete_font_shader_buffers();
+    delete_board_shader_buffers();
   }
 
   [[nodiscard]] auto solid_shader() const -> Shader::Program const& {
@@ -151,9 +212,29 @@ public:
     return m_rainbowShaderVAO;
   }
 
+  [[nodiscard]] auto font_shader() const -> Shader::Program const& {
+    return m_font;
+  }
   [[nodiscard]] auto font_shader_vao() const -> GLuint {
     return m_fontShaderVAO;
   }
+  [[nodiscard]] auto font_texture() const -> GLuint { return m_fontTexture; }
+
+  [[nodiscard]] auto board_shader() const -> Shader::Program const& {
+    return m_board;
+  }
+  [[nodiscard]] auto board_shader_vao() const -> GLuint {
+    return m_boardShaderVAO;
+  }
+  [[nodiscard]] auto board_texture() const -> GLuint {
+    return m_boardTexture;
+  }
+  // Uploads the board's visible cells to the board texture if they changed
+  // since the last upload, i.e. after a shape was locked or rows were
+  // cleared.
+  auto update_board_texture(Board const& board) -> void;
+
+  [[nodiscard]] auto stream_buffer() -> StreamBuffer& { return m_stream; }
 
 private:
   auto delete_solid_shader_buffers() -> void {
@@ -168,26 +249,38 @@ private:
   }
 
   auto delete_font_shader_buffers() -> void {
-    glDeleteBuffers(1, &m_fontShaderVBO);
+    glDeleteTextures(1, &m_fontTexture);
     glDeleteVertexArrays(1, &m_fontShaderVAO);
   }
 
+  auto delete_board_shader_buffers() -> void {
+    glDeleteTextures(1, &m_boardTexture);
+    glDeleteVertexArrays(1, &m_boardShaderVAO);
+  }
+
+  // Draws every solid rect of a frame at once, as instances of a unit square
+  // moved into each instance's rect.
   Shader::Program m_solid {
       R"foo(
         #version 330 core
         layout (location = 0) in vec3 aPos;
+        layout (location = 1) in vec4 aRect;
+        layout (location = 2) in vec4 aColor;
 
-        uniform mat4 model;
         uniform mat4 projection;
 
+        out vec4 color;
+
         void main() {
-            gl_Position = projection * model * vec4(aPos, 1.0);
+            vec2 position = aRect.xy + aPos.xy * aRect.zw;
+            gl_Position = projection * vec4(position, 0.0, 1.0);
+            color = aColor;
         }
         )foo",
       R"foo(
         #version 330 core
         out vec4 FragColor;
-        uniform vec4 color;
+        in vec4 color;
         void main() {
             FragColor = color;
         }
@@ -216,6 +309,72 @@ private:
         }
         )foo"};
 
+  // Draws every character of a frame at once, as quads covering the
+  // characters in the baked characters' bitmap. The bitmap only has a red
+  // channel, which is how much of each pixel the character covers.
+  Shader::Program m_font {
+      R"foo(
+        #version 330 core
+        layout (location = 0) in vec4 aVertex;
+
+        uniform mat4 projection;
+
+        out vec2 texCoords;
+
+        void main() {
+            gl_Position = projection * vec4(aVertex.xy, 0.0, 1.0);
+            texCoords = aVertex.zw;
+        }
+        )foo",
+      R"foo(
+        #version 330 core
+        out vec4 FragColor;
+        in vec2 texCoords;
+
+        uniform sampler2D bitmap;
+        uniform vec4 color;
+
+        void main() {
+            float coverage = texture(bitmap, texCoords).r;
+            FragColor = vec4(color.rgb, color.a * coverage);
+        }
+        )foo"};
+
+  // Draws the board's visible cells as a single quad. The cells are a
+  // texture with the kind of block in each of them, which is looked up in a
+  // palette of the kinds' colors.
+  Shader::Program m_board {
+      R"foo(
+        #version 330 core
+        uniform mat4 projection;
+        uniform vec4 rect;
+
+        out vec2 boardCoords;
+
+        void main() {
+            // The quad's corners, as a triangle strip.
+            vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+            gl_Position = projection * vec4(rect.xy + corner * rect.zw, 0.0,
+                                            1.0);
+            boardCoords = corner;
+        }
+        )foo",
+      R"foo(
+        #version 330 core
+        out vec4 FragColor;
+        in vec2 boardCoords;
+
+        uniform usampler2D cells;
+        uniform vec4 palette[9];
+
+        void main() {
+            ivec2 size = textureSize(cells, 0);
+            ivec2 cell = min(ivec2(boardCoords * vec2(size)), size - 1);
+            uint kind = texelFetch(cells, cell, 0).r;
+            FragColor = palette[min(kind, 8u)];
+        }
+        )foo"};
+
   GLuint m_solidShaderVAO {0};
   GLuint m_solidShaderVBO {0};
   GLuint m_solidShaderEBO {0};
@@ -225,11 +384,20 @@ private:
   GLuint m_rainbowShaderEBO {0};
 
   GLuint m_fontShaderVAO {0};
-  GLuint m_fontShaderVBO {0};
   GLuint m_fontTexture {0};
+
+  // The board's shader doesn't have any vertex attributes, but a vao still
+  // has to be bound to draw.
+  GLuint m_boardShaderVAO {0};
+  GLuint m_boardTexture {0};
+  // What's in the board texture.
+  std::optional<std::array<Block, Board::columns * Board::visibleRows>>
+      m_boardCells {};
+
+  StreamBuffer m_stream {};
 };
 
-auto draw(ProgramState& programState, GameState& gameState) -> void;
+auto draw(ProgramState& programState, GameState const& gameState) -> void;
 
 auto draw_solid_square_normalized(Rect<double> sqr, Color::RGBA color) -> void;
 auto draw_solid_square(Rect<int> sqr, Color::RGBA color) -> void;
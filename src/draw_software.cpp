@@ -1,60 +1,599 @@
 #include "draw_software.hpp"
 
+#include "blend.hpp"
+#include "damage.hpp"
 #include "font.hpp"
 #include "platform.hpp"
+#include "thread_pool.hpp"
 #include "ui.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <optional>
 #include <thread>
+#include <type_traits>
+#include <variant>
+#include <vector>
 
 namespace SoftwareRender {
 
-[[nodiscard]] auto static alpha_blend_channel(PositiveU8 const bg,
-                                              PositiveU8 const fg,
-                                              PositiveU8 const alpha)
-    -> PositiveU8 {
-  auto const alphaRatio = u8 {alpha} / 255.;
-  return static_cast<PositiveU8>(u8 {fg} * alphaRatio +
-                                 u8 {bg} * (1 - alphaRatio));
+[[nodiscard]] auto static pixel_address(BackBuffer const& buf,
+                                        std::size_t const x,
+                                        std::size_t const y) -> u8* {
+  return static_cast<u8*>(buf.memory) + y * uint {buf.pitch} +
+         x * u8 {buf.bpp};
 }
 
-auto static draw_pixel(void* data, Color::RGBA const color) -> void {
-  auto* byte {static_cast<u8*>(data)};
-  *byte = u8 {alpha_blend_channel(PositiveU8 {*byte}, color.b, color.a)};
-  ++byte;
-  *byte = u8 {alpha_blend_channel(PositiveU8 {*byte}, color.g, color.a)};
-  ++byte;
-  *byte = u8 {alpha_blend_channel(PositiveU8 {*byte}, color.r, color.a)};
+[[nodiscard]] auto static buffer_rect(BackBuffer const& buf) -> Rect<int> {
+  return {0, 0, static_cast<int>(uint {buf.dimensions.w}),
+          static_cast<int>(uint {buf.dimensions.h})};
 }
 
-auto static draw_font_character(BackBuffer& buf,
-                                FontCharacter const& fontCharacter,
-                                Point<int> const characterCoords) -> void {
-  for (int y {0}; y < fontCharacter.dimensions.h; ++y) {
-    auto const currY =
-        characterCoords.y + y + fontCharacter.yoff +
-        static_cast<int>(fontCharacter.ascent * fontCharacter.scale);
-    if (currY < 0 or static_cast<uint>(currY) >= uint {buf.dimensions.h}) {
-      continue;
+// Calls the function with the buffer's pixel format as a compile time
+// constant, so everything it draws is specialized for that format.
+template <typename Function>
+auto static with_pixel_format(PixelFormat const format, Function&& function)
+    -> void {
+  switch (format) {
+  case PixelFormat::XRGB8888: {
+    function(std::integral_constant<PixelFormat, PixelFormat::XRGB8888> {});
+  } break;
+  case PixelFormat::ARGB8888: {
+    function(std::integral_constant<PixelFormat, PixelFormat::ARGB8888> {});
+  } break;
+  case PixelFormat::RGB565: {
+    function(std::integral_constant<PixelFormat, PixelFormat::RGB565> {});
+  } break;
+  case PixelFormat::BGR24: {
+    function(std::integral_constant<PixelFormat, PixelFormat::BGR24> {});
+  } break;
+  }
+}
+
+// Everything is drawn clipped to a rect inside the buffer, which is either
+// the whole buffer or a damaged part of it.
+template <PixelFormat format>
+auto static fill_rect(BackBuffer const& buf, Rect<int> const clip,
+                      Rect<int> const rect, Color::RGBA const color) -> void {
+  auto const clipped = rect_intersection(rect, clip);
+  if (not clipped) {
+    return;
+  }
+
+  auto const width = static_cast<std::size_t>(clipped->w);
+  auto* row = pixel_address(buf, static_cast<std::size_t>(clipped->x),
+                            static_cast<std::size_t>(clipped->y));
+  for (int y {0}; y < clipped->h; ++y) {
+    Blend::span<format>(row, width, color);
+    row += uint {buf.pitch};
+  }
+}
+
+// `coverage` has a byte for every pixel of the rect.
+template <PixelFormat format>
+auto static fill_coverage(BackBuffer const& buf, Rect<int> const clip,
+                          Rect<int> const rect, u8 const* coverage,
+                          Color::RGBA const color) -> void {
+  auto const clipped = rect_intersection(rect, clip);
+  if (not clipped) {
+    return;
+  }
+
+  auto const width = static_cast<std::size_t>(clipped->w);
+  auto* row = pixel_address(buf, static_cast<std::size_t>(clipped->x),
+                            static_cast<std::size_t>(clipped->y));
+  coverage += static_cast<std::size_t>((clipped->y - rect.y) * rect.w +
+                                       (clipped->x - rect.x));
+  for (int y {0}; y < clipped->h; ++y) {
+    Blend::coverage_span<format>(row, coverage, width, color);
+    row += uint {buf.pitch};
+    coverage += rect.w;
+  }
+}
+
+[[nodiscard]] auto static hash_color(u64 const hash, Color::RGBA const color)
+    -> u64 {
+  return Damage::mix(hash, (u64 {u8 {color.r}} << 24U) |
+                               (u64 {u8 {color.g}} << 16U) |
+                               (u64 {u8 {color.b}} << 8U) | u8 {color.a});
+}
+
+[[nodiscard]] auto static hash_rect(u64 hash, Rect<int> const rect) -> u64 {
+  for (auto const value : {rect.x, rect.y, rect.w, rect.h}) {
+    hash = Damage::mix(hash, static_cast<u64>(value));
+  }
+  return hash;
+}
+
+// The background only depends on the back buffer's size and format, so it's
+// drawn into a cache once and then copied into the back buffer every frame.
+class BackgroundCache {
+public:
+  auto update(BackBuffer const bb, ThreadPool& pool) -> void;
+
+  auto copy(BackBuffer const& bb, Rect<int> const clip) const -> void {
+    auto const bpp = bytes_per_pixel(*m_format);
+    auto const rowSize = static_cast<std::size_t>(m_width) * bpp;
+    auto const offset = static_cast<std::size_t>(clip.x) * bpp;
+    auto const size = static_cast<std::size_t>(clip.w) * bpp;
+    for (auto y = clip.y; y < clip.y + clip.h; ++y) {
+      auto const row = static_cast<std::size_t>(y);
+      std::memcpy(pixel_address(bb, static_cast<std::size_t>(clip.x), row),
+                  m_pixels.data() + row * rowSize + offset, size);
     }
-    for (int x {0}; x < fontCharacter.dimensions.w; ++x) {
-      auto const currX = characterCoords.x + x + fontCharacter.xoff;
-      if (currX < 0 or static_cast<uint>(currX) >= uint {buf.dimensions.w}) {
+  }
+
+private:
+  std::vector<u8> m_pixels {};
+  uint m_width {0};
+  uint m_height {0};
+  std::optional<PixelFormat> m_format {};
+};
+
+// A frame is recorded as a list of commands first, so it can be compared
+// with the last one and then only drawn where it changed. Every command
+// knows the rect it covers, a hash of what it draws and how to draw itself
+// clipped to a rect.
+struct Background {
+  BackgroundCache const* cache {};
+  Rect<int> rect {};
+
+  [[nodiscard]] auto bounds() const -> Rect<int> { return rect; }
+  // The background only changes along with the buffer's size.
+  [[nodiscard]] auto hash() const -> u64 { return 0; }
+  template <PixelFormat format>
+  auto draw(BackBuffer const& buf, Rect<int> const clip) const -> void {
+    cache->copy(buf, clip);
+  }
+};
+
+struct SolidRect {
+  Rect<int> rect {};
+  Color::RGBA color {};
+
+  [[nodiscard]] auto bounds() const -> Rect<int> { return rect; }
+  [[nodiscard]] auto hash() const -> u64 {
+    return hash_color(hash_rect(1, rect), color);
+  }
+  template <PixelFormat format>
+  auto draw(BackBuffer const& buf, Rect<int> const clip) const -> void {
+    fill_rect<format>(buf, clip, rect, color);
+  }
+};
+
+// The glyph's bitmap is copied, since the string it's from is usually gone
+// by the time it's drawn.
+struct Glyph {
+  Rect<int> rect {};
+  std::vector<u8> coverage {};
+  u64 glyphHash {};
+
+  [[nodiscard]] auto bounds() const -> Rect<int> { return rect; }
+  [[nodiscard]] auto hash() const -> u64 {
+    return hash_rect(glyphHash, rect);
+  }
+  template <PixelFormat format>
+  auto draw(BackBuffer const& buf, Rect<int> const clip) const -> void {
+    fill_coverage<format>(buf, clip, rect, coverage.data(), Color::black);
+  }
+};
+
+// Copies `count` pixels' worth of bytes from the start of `row` onto the rest
+// of it, doubling the copied area each time so it's only a few memcpys.
+auto static repeat_pixel(u8* const row, std::size_t const count,
+                         std::size_t const bytesPerPixel) -> void {
+  auto const size = count * bytesPerPixel;
+  for (auto filled = bytesPerPixel; filled < size; filled *= 2) {
+    std::memcpy(row + filled, row, std::min(filled, size - filled));
+  }
+}
+
+// A grid of square cells, e.g. the board, drawn as a tiny image with a pixel
+// per cell and then scaled up when it's drawn into the buffer. The cells are
+// blended in the tiny image, so drawing into the buffer is just copying, and
+// the cost of drawing them barely grows with the window's scale.
+class CellImage {
+public:
+  CellImage(Point<int> const origin, int const cellSize,
+            Rect<int>::Size const cells, PixelFormat const format)
+      : m_origin {origin}, m_cellSize {cellSize}, m_cells {cells},
+        m_format {format},
+        m_pixels(static_cast<std::size_t>(cells.w * cells.h) *
+                 bytes_per_pixel(format)),
+        m_drawn(static_cast<std::size_t>(cells.w * cells.h)) {}
+
+  // Cells outside the grid are ignored. A translucent color is blended over
+  // the cell, so there has to be something opaque in it already.
+  auto fill(Point<int> const cell, Color::RGBA const color) -> void {
+    if (cell.x < 0 or cell.x >= m_cells.w or cell.y < 0 or
+        cell.y >= m_cells.h) {
+      return;
+    }
+    auto const index = static_cast<std::size_t>(cell.y * m_cells.w + cell.x);
+    assert(m_drawn[index] or
+           u8 {color.a} == Color::RGBA::Alpha::opaque);
+    m_drawn[index] = 1;
+    auto* const pixel = m_pixels.data() + index * bytes_per_pixel(m_format);
+    with_pixel_format(m_format, [&](auto const format) {
+      Blend::span<decltype(format)::value>(pixel, 1, color);
+    });
+  }
+
+  [[nodiscard]] auto bounds() const -> Rect<int> {
+    return {m_origin.x, m_origin.y, m_cells.w * m_cellSize,
+            m_cells.h * m_cellSize};
+  }
+
+  // Only hashes the cells inside the tile, so a shape moving only damages
+  // the tiles around it instead of all of the image.
+  [[nodiscard]] auto tile_hash(Rect<int> const tile) const -> u64 {
+    auto hash = hash_rect(3, bounds());
+    auto const clipped = rect_intersection(bounds(), tile);
+    if (not clipped) {
+      return hash;
+    }
+
+    auto const bytesPerPixel = std::size_t {bytes_per_pixel(m_format)};
+    auto const firstColumn = (clipped->x - m_origin.x) / m_cellSize;
+    auto const endColumn =
+        (clipped->x + clipped->w - 1 - m_origin.x) / m_cellSize + 1;
+    auto const firstRow = (clipped->y - m_origin.y) / m_cellSize;
+    auto const endRow =
+        (clipped->y + clipped->h - 1 - m_origin.y) / m_cellSize + 1;
+    for (auto row = firstRow; row < endRow; ++row) {
+      for (auto column = firstColumn; column < endColumn; ++column) {
+        auto const index = static_cast<std::size_t>(row * m_cells.w + column);
+        hash = Damage::mix(hash, m_drawn[index]);
+        for (std::size_t i {0}; i < bytesPerPixel; ++i) {
+          hash = Damage::mix(hash, m_pixels[index * bytesPerPixel + i]);
+        }
+      }
+    }
+    return hash;
+  }
+
+  template <PixelFormat format>
+  auto draw(BackBuffer const& buf, Rect<int> const clip) const -> void {
+    auto constexpr bytesPerPixel = bytes_per_pixel(format);
+    auto const clipped = rect_intersection(bounds(), clip);
+    if (not clipped) {
+      return;
+    }
+
+    auto const firstColumn = (clipped->x - m_origin.x) / m_cellSize;
+    auto const endColumn =
+        (clipped->x + clipped->w - 1 - m_origin.x) / m_cellSize + 1;
+    auto y = clipped->y;
+    while (y < clipped->y + clipped->h) {
+      auto const cellRow = (y - m_origin.y) / m_cellSize;
+      auto const endY = std::min(clipped->y + clipped->h,
+                                 m_origin.y + (cellRow + 1) * m_cellSize);
+
+      // The first row of pixels is expanded from the cells, and every other
+      // row of the same cells is a copy of it.
+      auto* const firstRow = pixel_address(buf, 0, static_cast<std::size_t>(y));
+      for (auto column = firstColumn; column < endColumn; ++column) {
+        auto const index =
+            static_cast<std::size_t>(cellRow * m_cells.w + column);
+        if (not m_drawn[index]) {
+          continue;
+        }
+        auto const startX =
+            std::max(clipped->x, m_origin.x + column * m_cellSize);
+        auto const endX = std::min(clipped->x + clipped->w,
+                                   m_origin.x + (column + 1) * m_cellSize);
+        auto* const start =
+            firstRow + static_cast<std::size_t>(startX) * bytesPerPixel;
+        std::memcpy(start, m_pixels.data() + index * bytesPerPixel,
+                    bytesPerPixel);
+        repeat_pixel(start, static_cast<std::size_t>(endX - startX),
+                     bytesPerPixel);
+      }
+
+      for (auto copyY = y + 1; copyY < endY; ++copyY) {
+        auto* const row =
+            pixel_address(buf, 0, static_cast<std::size_t>(copyY));
+        copy_drawn_runs<bytesPerPixel>(row, firstRow, *clipped, cellRow,
+                                       firstColumn, endColumn);
+      }
+      y = endY;
+    }
+  }
+
+private:
+  // Copies the pixels of every run of drawn cells in the row.
+  template <u8 bytesPerPixel>
+  auto copy_drawn_runs(u8* const row, u8 const* const source,
+                       Rect<int> const& clipped, int const cellRow,
+                       int const firstColumn, int const endColumn) const
+      -> void {
+    auto const is_drawn = [&](int const column) {
+      return m_drawn[static_cast<std::size_t>(cellRow * m_cells.w + column)] !=
+             0;
+    };
+    auto column = firstColumn;
+    while (column < endColumn) {
+      if (not is_drawn(column)) {
+        ++column;
         continue;
       }
+      auto const runStart = column;
+      while (column < endColumn and is_drawn(column)) {
+        ++column;
+      }
+      auto const startX =
+          std::max(clipped.x, m_origin.x + runStart * m_cellSize);
+      auto const endX =
+          std::min(clipped.x + clipped.w, m_origin.x + column * m_cellSize);
+      auto const offset = static_cast<std::size_t>(startX) * bytesPerPixel;
+      std::memcpy(row + offset, source + offset,
+                  static_cast<std::size_t>(endX - startX) * bytesPerPixel);
+    }
+  }
+
+  Point<int> m_origin;
+  int m_cellSize;
+  Rect<int>::Size m_cells;
+  PixelFormat m_format;
+  std::vector<u8> m_pixels;
+  std::vector<u8> m_drawn;
+};
+
+// A shape drawn at full size ahead of time, so drawing it is a copy of each
+// of its rows.
+struct Sprite {
+  int cellSize {};
+  std::size_t bytesPerPixel {};
+  std::vector<u8> pixels {};
+  // The runs of blocks in every row of the shape's layout, as the first and
+  // last column plus one.
+  std::array<std::vector<std::pair<int, int>>, ShapeBase::layoutDimensions.h>
+      runs {};
+
+  [[nodiscard]] auto size() const -> Rect<int>::Size {
+    return {static_cast<int>(ShapeBase::layoutDimensions.w) * cellSize,
+            static_cast<int>(ShapeBase::layoutDimensions.h) * cellSize};
+  }
+};
+
+// Every shape in every rotation, in its own color, drawn at the current
+// window scale. Sprites are drawn the first time they're needed and kept
+// until the scale or the pixel format changes.
+class SpriteCache {
+public:
+  auto update(int const scale, PixelFormat const format) -> void {
+    if (scale == m_scale and format == m_format) {
+      return;
+    }
+    m_scale = scale;
+    m_format = format;
+    for (auto& sprite : m_sprites) {
+      sprite.reset();
+    }
+  }
+
+  [[nodiscard]] auto get(ShapeBase::Type const type,
+                         ShapeBase::Rotation const rotation) -> Sprite const& {
+    auto& sprite =
+        m_sprites[static_cast<std::size_t>(type) * rotationCount +
+                  static_cast<std::size_t>(rotation)];
+    if (not sprite) {
+      sprite = make_sprite(type, rotation);
+    }
+    return *sprite;
+  }
+
+private:
+  std::size_t static constexpr rotationCount {4};
+
+  [[nodiscard]] auto make_sprite(ShapeBase::Type const type,
+                                 ShapeBase::Rotation const rotation) const
+      -> Sprite {
+    Sprite sprite {};
+    sprite.cellSize = m_scale;
+    sprite.bytesPerPixel = bytes_per_pixel(*m_format);
+    auto const size = sprite.size();
+    sprite.pixels.resize(static_cast<std::size_t>(size.w * size.h) *
+                         sprite.bytesPerPixel);
+    BackBuffer const buffer {
+        sprite.pixels.data(),
+        {static_cast<uint>(size.w), static_cast<uint>(size.h)},
+        PositiveUInt {static_cast<std::size_t>(size.w) *
+                      sprite.bytesPerPixel},
+        PositiveU8 {bytes_per_pixel(*m_format)},
+        *m_format};
+
+    auto const& layout = Shape::RotationSystem::layout(type, rotation);
+    auto const columns = static_cast<int>(ShapeBase::layoutDimensions.w);
+    for (std::size_t row {0}; row < sprite.runs.size(); ++row) {
+      auto const is_block = [&](int const column) {
+        return layout[row * ShapeBase::layoutDimensions.w +
+                      static_cast<std::size_t>(column)];
+      };
+      int column {0};
+      while (column < columns) {
+        if (not is_block(column)) {
+          ++column;
+          continue;
+        }
+        auto const start = column;
+        while (column < columns and is_block(column)) {
+          ++column;
+        }
+        sprite.runs[row].emplace_back(start, column);
+        Rect<int> const run {start * m_scale,
+                             static_cast<int>(row) * m_scale,
+                             (column - start) * m_scale, m_scale};
+        with_pixel_format(*m_format, [&](auto const format) {
+          fill_rect<decltype(format)::value>(buffer, buffer_rect(buffer), run,
+                                             ShapeBase::to_color(type));
+        });
+      }
+    }
+    return sprite;
+  }
+
+  int m_scale {0};
+  std::optional<PixelFormat> m_format {};
+  std::array<std::optional<Sprite>, ShapeBase::typeCount * rotationCount>
+      m_sprites {};
+};
+
+struct SpriteBlit {
+  Sprite const* sprite {};
+  Point<int> origin {};
+  // Identifies the sprite, so the hash changes when the shape does.
+  u64 key {};
+
+  [[nodiscard]] auto bounds() const -> Rect<int> {
+    auto const size = sprite->size();
+    return {origin.x, origin.y, size.w, size.h};
+  }
+  [[nodiscard]] auto hash() const -> u64 {
+    return hash_rect(Damage::mix(4, key), bounds());
+  }
+  template <PixelFormat format>
+  auto draw(BackBuffer const& buf, Rect<int> const clip) const -> void {
+    auto const clipped = rect_intersection(bounds(), clip);
+    if (not clipped) {
+      return;
+    }
+
+    auto const rowSize = static_cast<std::size_t>(sprite->size().w) *
+                         sprite->bytesPerPixel;
+    for (auto y = clipped->y; y < clipped->y + clipped->h; ++y) {
+      auto const spriteY = y - origin.y;
+      auto const& runs =
+          sprite->runs[static_cast<std::size_t>(spriteY / sprite->cellSize)];
+      auto* const row = pixel_address(buf, 0, static_cast<std::size_t>(y));
+      auto const* const source =
+          sprite->pixels.data() + static_cast<std::size_t>(spriteY) * rowSize;
+      for (auto const& [start, end] : runs) {
+        auto const startX =
+            std::max(clipped->x, origin.x + start * sprite->cellSize);
+        auto const endX = std::min(clipped->x + clipped->w,
+                                   origin.x + end * sprite->cellSize);
+        if (startX >= endX) {
+          continue;
+        }
+        std::memcpy(row + static_cast<std::size_t>(startX) *
+                              sprite->bytesPerPixel,
+                    source + static_cast<std::size_t>(startX - origin.x) *
+                                 sprite->bytesPerPixel,
+                    static_cast<std::size_t>(endX - startX) *
+                        sprite->bytesPerPixel);
+      }
+    }
+  }
+};
+
+using Command =
+    std::variant<Background, SolidRect, Glyph, CellImage, SpriteBlit>;
+
+// The commands that overlap each tile of the frame, in the order they were
+// recorded. Tiles can then be drawn on their own, on any thread, touching
+// only the commands that matter to them.
+class TileBins {
+public:
+  auto bin(std::vector<Command> const& commands, Rect<int>::Size const size)
+      -> void {
+    m_columns = (size.w + Damage::tileSize - 1) / Damage::tileSize;
+    auto const rows = (size.h + Damage::tileSize - 1) / Damage::tileSize;
+    auto const tileCount = static_cast<std::size_t>(m_columns * rows);
+
+    // Counts the commands in each tile first, so all of the bins can share a
+    // single array.
+    m_tiles.resize(commands.size());
+    m_offsets.assign(tileCount + 1, 0);
+    for (std::size_t i {0}; i < commands.size(); ++i) {
+      m_tiles[i] = std::visit(
+          [size](auto const& c) {
+            return Damage::overlapped_tiles(c.bounds(), size);
+          },
+          commands[i]);
+      for_each_tile(m_tiles[i], [this](std::size_t const tile) {
+        ++m_offsets[tile + 1];
+      });
+    }
+    for (std::size_t tile {0}; tile < tileCount; ++tile) {
+      m_offsets[tile + 1] += m_offsets[tile];
+    }
 
-      auto const currbyteindex =
-          static_cast<uint>(currY) * uint {buf.dimensions.w} +
-          static_cast<uint>(currX);
-      auto* currbyte =
-          static_cast<u8*>(buf.memory) + (currbyteindex * u8 {buf.bpp});
+    m_indices.resize(m_offsets.back());
+    m_ends.assign(m_offsets.begin(), m_offsets.end() - 1);
+    for (std::size_t i {0}; i < commands.size(); ++i) {
+      for_each_tile(m_tiles[i], [this, i](std::size_t const tile) {
+        m_indices[m_ends[tile]++] = static_cast<u32>(i);
+      });
+    }
+  }
 
-      auto const relativeIndex =
-          static_cast<std::size_t>(y * fontCharacter.dimensions.w + x);
-      auto const a = fontCharacter.bitmap[relativeIndex];
+  [[nodiscard]] auto commands_in(int const column, int const row) const
+      -> gsl::span<u32 const> {
+    auto const tile = static_cast<std::size_t>(row * m_columns + column);
+    return {m_indices.data() + m_offsets[tile],
+            m_offsets[tile + 1] - m_offsets[tile]};
+  }
 
-      draw_pixel(currbyte, Color::RGBA {0u, 0u, 0u, a});
+private:
+  template <typename Function>
+  auto for_each_tile(std::optional<Rect<int>> const& tiles,
+                     Function&& function) const -> void {
+    if (not tiles) {
+      return;
     }
+    for (auto row = tiles->y; row < tiles->y + tiles->h; ++row) {
+      for (auto column = tiles->x; column < tiles->x + tiles->w; ++column) {
+        function(static_cast<std::size_t>(row * m_columns + column));
+      }
+    }
+  }
+
+  int m_columns {0};
+  // The tiles each command overlaps.
+  std::vector<std::optional<Rect<int>>> m_tiles {};
+  // Where each tile's bin starts in m_indices, plus where the last one ends.
+  std::vector<std::size_t> m_offsets {};
+  std::vector<std::size_t> m_ends {};
+  std::vector<u32> m_indices {};
+};
+
+// While a frame is being recorded, the drawing functions add commands to it
+// instead of drawing right away.
+std::vector<Command> static* recording {nullptr};
+
+auto static draw_font_character(BackBuffer& buf,
+                                FontCharacter const& fontCharacter,
+                                Point<int> const characterCoords) -> void {
+  Rect<int> const rect {
+      characterCoords.x + fontCharacter.xoff,
+      characterCoords.y + fontCharacter.yoff +
+          static_cast<int>(fontCharacter.ascent * fontCharacter.scale),
+      fontCharacter.dimensions.w, fontCharacter.dimensions.h};
+  if (rect.w <= 0 or rect.h <= 0) {
+    return;
+  }
+
+  if (not recording) {
+    with_pixel_format(buf.format, [&](auto const format) {
+      fill_coverage<decltype(format)::value>(buf, buffer_rect(buf), rect,
+                                             fontCharacter.bitmap,
+                                             Color::black);
+    });
+    return;
   }
+
+  // The same character at the same scale always has the same bitmap.
+  u64 scaleBits {};
+  std::memcpy(&scaleBits, &fontCharacter.scale, sizeof(scaleBits));
+  auto const hash = Damage::mix(
+      Damage::mix(2, static_cast<u64>(fontCharacter.character)), scaleBits);
+  auto const* const bitmap = fontCharacter.bitmap;
+  recording->push_back(Glyph {
+      rect,
+      {bitmap, bitmap + static_cast<std::ptrdiff_t>(rect.w * rect.h)},
+      hash});
 }
 
 auto draw_font_string(BackBuffer& buf, FontString const& fontString,
@@ -92,24 +631,13 @@ auto draw_text_normalized(BackBuffer& buf, std::string_view const text,
 
 auto draw_solid_square(BackBuffer& buf, Rect<int> const sqr,
                        Color::RGBA const color) -> void {
-  for (int y {0}; y < sqr.h; ++y) {
-    auto const pixely = static_cast<std::size_t>(sqr.y + y);
-    if ((sqr.y + y) < 0 or pixely >= uint {buf.dimensions.h}) {
-      continue;
-    }
-    for (int x {0}; x < sqr.w; ++x) {
-      auto const pixelx = static_cast<std::size_t>(sqr.x + x);
-      if ((sqr.x + x) < 0 or pixelx >= uint {buf.dimensions.w}) {
-        continue;
-      }
-
-      auto const currbyteindex = pixely * uint {buf.dimensions.w} + pixelx;
-      auto* currbyte {static_cast<u8*>(buf.memory) +
-                      (currbyteindex * u8 {buf.bpp})};
-
-      draw_pixel(currbyte, color);
-    }
+  if (recording) {
+    recording->push_back(SolidRect {sqr, color});
+    return;
   }
+  with_pixel_format(buf.format, [&](auto const format) {
+    fill_rect<decltype(format)::value>(buf, buffer_rect(buf), sqr, color);
+  });
 }
 
 auto draw_solid_square_normalized(BackBuffer& buf, Rect<double> sqr,
@@ -124,32 +652,26 @@ auto draw_solid_square_normalized(BackBuffer& buf, Rect<double> sqr,
 
 auto draw_hollow_square(BackBuffer& buf, Rect<int> const sqr,
                         Color::RGBA const color, int const borderSize) -> void {
-  for (int y {0}; y < sqr.h; ++y) {
-    auto const pixely = static_cast<std::size_t>(sqr.y + y);
-    if (sqr.y + y < 0 or pixely >= uint {buf.dimensions.h}) {
-      continue;
-    }
-    for (int x {0}; x < sqr.w; ++x) {
-      auto const pixelx = static_cast<std::size_t>(sqr.x + x);
-      if (sqr.x + x < 0 or pixelx >= uint {buf.dimensions.w}) {
-        continue;
-      }
-
-      // check if pixel is part of border
-      if (not point_is_in_rect(Point<int> {x, y}, {0, 0, sqr.w, sqr.h}) or
-          point_is_in_rect(Point<int> {x, y},
-                           {borderSize, borderSize, sqr.w - borderSize * 2,
-                            sqr.h - borderSize * 2})) {
-        continue;
-      }
-
-      auto const currbyteindex = pixely * uint {buf.dimensions.w} + pixelx;
-      auto* currbyte {static_cast<u8*>(buf.memory) +
-                      (currbyteindex * u8 {buf.bpp})};
-
-      draw_pixel(currbyte, color);
-    }
+  if (sqr.w <= 0 or sqr.h <= 0) {
+    return;
   }
+
+  // The border is drawn as four filled rects that don't overlap, so
+  // translucent borders don't get blended twice in the corners. A border
+  // wider than half the square fills it completely.
+  auto const top = std::clamp(borderSize, 0, sqr.h);
+  auto const bottom = std::clamp(borderSize, 0, sqr.h - top);
+  auto const left = std::clamp(borderSize, 0, sqr.w);
+  auto const right = std::clamp(borderSize, 0, sqr.w - left);
+  auto const middleHeight = sqr.h - top - bottom;
+
+  draw_solid_square(buf, {sqr.x, sqr.y, sqr.w, top}, color);
+  draw_solid_square(buf, {sqr.x, sqr.y + sqr.h - bottom, sqr.w, bottom},
+                    color);
+  draw_solid_square(buf, {sqr.x, sqr.y + top, left, middleHeight}, color);
+  draw_solid_square(buf,
+                    {sqr.x + sqr.w - right, sqr.y + top, right, middleHeight},
+                    color);
 }
 
 auto draw_hollow_square_normalized(BackBuffer& buf, Rect<double> sqr,
@@ -194,6 +716,7 @@ auto draw_hollow_square_normalized(BackBuffer& buf, Rect<double> sqr,
 /*     } */
 /* } */
 
+template <PixelFormat format>
 auto static draw_background_rows(BackBuffer bb, PositiveSize_t const startRow,
                                  PositiveSize_t const endRow) {
   for (std::size_t y {startRow}; y < endRow; ++y) {
@@ -212,123 +735,129 @@ auto static draw_background_rows(BackBuffer bb, PositiveSize_t const startRow,
                           (static_cast<double>(y) /
                            static_cast<double>(uint {bb.dimensions.h}))),
       };
-      draw_solid_square(bb, {static_cast<int>(x), static_cast<int>(y), 1, 1},
-                        color);
+      fill_rect<format>(bb, buffer_rect(bb),
+                {static_cast<int>(x), static_cast<int>(y), 1, 1}, color);
     }
   }
 }
 
-auto static draw_playarea_rows(BackBuffer bb, PositiveSize_t const startRow,
-                               PositiveSize_t const endRow, Board const& board,
-                               PositiveUInt const positiveScale) {
-  uint const scale {positiveScale};
-  for (std::size_t y {startRow}; y < endRow; ++y) {
-    for (std::size_t x {0}; x < Board::columns; ++x) {
-      auto currindex = gsl::narrow_cast<gsl::index>(y * Board::columns + x);
-      auto const& block = board.block_at(currindex);
-      auto color = block.isActive ? block.color : Color::black;
-      Rect<int> square {static_cast<int>((x + gPlayAreaDim.x) * scale),
-                        static_cast<int>((y - 2 + gPlayAreaDim.y) * scale),
-                        static_cast<int>(scale), static_cast<int>(scale)};
-      draw_solid_square(bb, square, color);
-    }
+auto BackgroundCache::update(BackBuffer const bb, ThreadPool& pool) -> void {
+  uint const width {bb.dimensions.w};
+  uint const height {bb.dimensions.h};
+  if (width == m_width and height == m_height and bb.format == m_format) {
+    return;
   }
+
+  m_width = width;
+  m_height = height;
+  m_format = bb.format;
+  auto const rowSize = static_cast<std::size_t>(width) * u8 {bb.bpp};
+  m_pixels.assign(rowSize * height, 0);
+  BackBuffer const cache {m_pixels.data(), bb.dimensions,
+                          PositiveUInt {rowSize}, bb.bpp, bb.format};
+  with_pixel_format(bb.format, [&](auto const format) {
+    pool.for_each_row_range(
+        height, width,
+        [cache](std::size_t const startRow, std::size_t const endRow) {
+          draw_background_rows<decltype(format)::value>(cache, startRow,
+                                                        endRow);
+        });
+  });
 }
 
-auto draw(ProgramState& programState, GameState& gameState) -> void {
+// The workers are created on the first frame and kept until the thread count
+// changes.
+std::size_t static threadCount {std::thread::hardware_concurrency()};
+std::unique_ptr<ThreadPool> static threadPool {};
+
+[[nodiscard]] auto static thread_pool() -> ThreadPool& {
+  if (not threadPool) {
+    threadPool = std::make_unique<ThreadPool>(threadCount);
+  }
+  return *threadPool;
+}
+
+auto set_thread_count(std::size_t const count) -> void {
+  if (count != threadCount) {
+    threadCount = count;
+    threadPool.reset();
+  }
+}
+
+// Everything drawn in the last frame is compared against to find the damage.
+Damage::Tracker static damage {};
+BackgroundCache static background {};
+
+auto invalidate() -> void { damage.invalidate(); }
+
+auto draw(ProgramState& programState, GameState const& gameState)
+    -> std::vector<Rect<int>> {
   auto bb = get_back_buffer();
   auto const scale = get_window_scale();
-  auto const threadCount = std::thread::hardware_concurrency();
-  std::vector<std::thread> threads {};
-  threads.reserve(threadCount);
+  auto& pool = thread_pool();
 
-  auto const join_all = [](auto& threadContainer) {
-    for (auto& thread : threadContainer) {
-      thread.join();
-    }
-    threadContainer.clear();
-  };
+  static std::vector<Command> commands {};
+  commands.clear();
+  recording = &commands;
 
   // draw window background
-  {
-    auto const rowsPerThread = uint {bb.dimensions.h} / threadCount;
-    for (std::size_t i {0}; i < threadCount - 1; ++i) {
-      threads.emplace_back(&draw_background_rows, bb,
-                           PositiveSize_t {rowsPerThread * i},
-                           PositiveSize_t {rowsPerThread * (i + 1)});
-    }
-    threads.emplace_back(&draw_background_rows, bb,
-                         PositiveSize_t {rowsPerThread * (threadCount - 1)},
-                         bb.dimensions.h);
-    join_all(threads);
-  }
+  background.update(bb, pool);
+  commands.push_back(Background {&background, buffer_rect(bb)});
 
   switch (programState.levelType) {
   case ProgramState::LevelType::Menu: {
   } break;
   case ProgramState::LevelType::Game: {
-    // draw playarea
-    {
-      PositiveUInt const positiveScale {scale};
-      auto const rowsPerThread = (Board::rows - 2) / threadCount;
-      for (std::size_t i {0}; i < threadCount - 1; ++i) {
-        threads.emplace_back(&draw_playarea_rows, bb,
-                             PositiveSize_t {2 + (rowsPerThread * i)},
-                             PositiveSize_t {2 + rowsPerThread * (i + 1)},
-                             gameState.board, positiveScale);
+    // draw playarea, with currentShape and its shadow
+    auto constexpr hiddenRows = Board::rows - Board::visibleRows;
+    CellImage playArea {{gPlayAreaDim.x * scale, gPlayAreaDim.y * scale},
+                        scale,
+                        {Board::columns, Board::visibleRows},
+                        bb.format};
+    for (int y {0}; y < Board::visibleRows; ++y) {
+      for (int x {0}; x < Board::columns; ++x) {
+        auto const index = gsl::narrow_cast<gsl::index>(
+            (y + hiddenRows) * Board::columns + x);
+        playArea.fill({x, y}, gameState.board.block_at(index).color());
       }
-      threads.emplace_back(
-          &draw_playarea_rows, bb,
-          PositiveSize_t {2 + rowsPerThread * (threadCount - 1)},
-          PositiveSize_t {Board::rows}, gameState.board, positiveScale);
-      join_all(threads);
     }
 
-    // draw currentShape and its shadow
-    auto draw_shape_in_play_area = [&](Shape& shape) {
-      for (auto& position : shape.get_absolute_block_positions()) {
+    auto draw_shape_in_play_area = [&](Shape const& shape) {
+      for (auto const& position : shape.get_absolute_block_positions()) {
         // since the top 2 rows shouldn't be visible, the y
-        // position for drawing is 2 less than the shape's
-        auto const actualYPosition = position.y - 2;
-
-        // don't draw if square is above the playarea
-        if (actualYPosition + gPlayAreaDim.y < gPlayAreaDim.y) {
-          continue;
-        }
-        Rect<int> square {(position.x + gPlayAreaDim.x) * scale,
-                          (actualYPosition + gPlayAreaDim.y) * scale, scale,
-                          scale};
-
-        draw_solid_square(bb, square, shape.color);
+        // position for drawing is 2 less than the shape's.
+        // Blocks above the playarea are skipped by the image.
+        playArea.fill({position.x, position.y - hiddenRows}, shape.color);
       }
     };
 
     draw_shape_in_play_area(gameState.currentShapeShadow);
     draw_shape_in_play_area(gameState.currentShape);
+    commands.push_back(std::move(playArea));
+
+    static SpriteCache sprites {};
+    sprites.update(scale, bb.format);
+    auto const blit_sprite = [&](Shape const& shape, Point<int> const origin) {
+      auto const key = static_cast<u64>(shape.type()) * 4U +
+                       static_cast<u64>(shape.rotation());
+      commands.push_back(SpriteBlit {
+          &sprites.get(shape.type(), shape.rotation()), origin, key});
+    };
 
     // draw shape previews
-    auto const previewArray = gameState.shapePool.get_preview_shapes_array();
-    auto i = 0;
-    for (auto const shapeType : previewArray) {
-      Shape shape {shapeType};
-      shape.pos.x = gSidebarDim.x;
-      auto const ySpacing =
-          3; // max height of a shape is 2 + 1 for a block of space
-      shape.pos.y = gSidebarDim.y + ySpacing * i;
-      for (auto& position : shape.get_absolute_block_positions()) {
-        Rect<int> square {(position.x) * scale, (position.y) * scale, scale,
-                          scale};
-        draw_solid_square(bb, square, shape.color);
-      }
-      ++i;
+    for (auto i = 0; i < gPreviewShapeCount; ++i) {
+      Shape const shape {
+          gameState.shapePool.peek(static_cast<std::size_t>(i) + 1)};
+      blit_sprite(shape,
+                  {gSidebarDim.x * scale,
+                   (gSidebarDim.y + gPreviewShapeSpacing * i) * scale});
     }
 
     // draw held shape
     auto const holdShapeDim = gHoldShapeDim * scale;
     draw_solid_square(bb, holdShapeDim, Color::black);
     if (gameState.holdShapeType) {
-      Shape shape {*gameState.holdShapeType};
-      shape.pos = {};
+      Shape const shape {*gameState.holdShapeType};
 
       auto is_even = [](auto const n) { return (n % 2) == 0; };
       // offset to center shape inside hold square
@@ -338,18 +867,152 @@ auto draw(ProgramState& programState, GameState& gameState) -> void {
       auto const yOffset =
           is_even(gHoldShapeDim.h - shapeDimensions.h) ? 0.0 : 0.5;
 
-      for (auto& position : shape.get_absolute_block_positions()) {
-        Rect<int> square {
-            static_cast<int>((position.x + gHoldShapeDim.x + xOffset) * scale),
-            static_cast<int>((position.y + gHoldShapeDim.y + yOffset) * scale),
-            scale, scale};
-        draw_solid_square(bb, square, shape.color);
-      }
+      blit_sprite(shape,
+                  {static_cast<int>((gHoldShapeDim.x + xOffset) * scale),
+                   static_cast<int>((gHoldShapeDim.y + yOffset) * scale)});
     }
   } break;
   }
 
   UI::draw(bb);
+  recording = nullptr;
+
+  // The buffer's pixels are only still there if it's the same buffer.
+  static void* lastMemory {};
+  if (bb.memory != lastMemory) {
+    lastMemory = bb.memory;
+    damage.invalidate();
+  }
+  Rect<int>::Size const frameSize {static_cast<int>(uint {bb.dimensions.w}),
+                                   static_cast<int>(uint {bb.dimensions.h})};
+  damage.begin_frame(frameSize);
+  for (auto const& command : commands) {
+    std::visit(
+        [](auto const& c) {
+          if constexpr (std::is_same_v<std::decay_t<decltype(c)>,
+                                       CellImage>) {
+            damage.add_per_tile(c.bounds(), [&c](Rect<int> const tile) {
+              return c.tile_hash(tile);
+            });
+          } else {
+            damage.add(c.bounds(), c.hash());
+          }
+        },
+        command);
+  }
+  auto const damagedRects = damage.end_frame();
+
+  // Every damaged tile is drawn on its own. Tiles don't overlap, so they can
+  // be drawn at the same time, and a tile is small enough that it stays in
+  // the cache while every command over it is drawn.
+  static TileBins bins {};
+  bins.bin(commands, frameSize);
+  static std::vector<Rect<int>> tiles {};
+  tiles.clear();
+  for (auto const& rect : damagedRects) {
+    for (auto x = rect.x; x < rect.x + rect.w; x += Damage::tileSize) {
+      tiles.push_back({x, rect.y,
+                       std::min(Damage::tileSize, rect.x + rect.w - x),
+                       rect.h});
+    }
+  }
+  with_pixel_format(bb.format, [&](auto const format) {
+    pool.for_each(tiles.size(), [&](std::size_t const i) {
+      auto const& tile = tiles[i];
+      auto const indices = bins.commands_in(tile.x / Damage::tileSize,
+                                            tile.y / Damage::tileSize);
+      for (auto const index : indices) {
+        std::visit(
+            [&](auto const& c) {
+              c.template draw<decltype(format)::value>(bb, tile);
+            },
+            commands[index]);
+      }
+    });
+  });
+
+  return Damage::merge_vertically(damagedRects);
+}
+
+auto draw_wall(std::vector<Spectate::BoardView> const& boards)
+    -> std::vector<Rect<int>> {
+  auto bb = get_back_buffer();
+  auto& pool = thread_pool();
+  Rect<int>::Size const frameSize {static_cast<int>(uint {bb.dimensions.w}),
+                                   static_cast<int>(uint {bb.dimensions.h})};
+  auto const layout = Spectate::Layout::of(boards.size(), frameSize);
+
+  // The boards stay where they are until the buffer changes, so only the
+  // boards whose version changed have to be redrawn. If the buffer's pixels
+  // are gone, everything is.
+  static void* lastMemory {};
+  static Rect<int>::Size lastSize {};
+  static std::optional<PixelFormat> lastFormat {};
+  static std::vector<std::optional<u64>> drawnVersions {};
+  auto const redrawAll = bb.memory != lastMemory or
+                         frameSize.w != lastSize.w or
+                         frameSize.h != lastSize.h or
+                         bb.format != lastFormat or
+                         drawnVersions.size() != boards.size();
+  if (redrawAll) {
+    lastMemory = bb.memory;
+    lastSize = frameSize;
+    lastFormat = bb.format;
+    drawnVersions.assign(boards.size(), std::nullopt);
+
+    background.update(bb, pool);
+    pool.for_each_row_range(
+        static_cast<std::size_t>(frameSize.h),
+        static_cast<std::size_t>(frameSize.w),
+        [&bb, &frameSize](std::size_t const startRow,
+                          std::size_t const endRow) {
+          background.copy(bb, {0, static_cast<int>(startRow), frameSize.w,
+                               static_cast<int>(endRow - startRow)});
+        });
+    // The game's frames can't tell what the wall drew over.
+    damage.invalidate();
+  }
+
+  static std::vector<std::size_t> changed {};
+  changed.clear();
+  for (std::size_t i {0}; i < boards.size(); ++i) {
+    if (drawnVersions[i] != boards[i].version) {
+      drawnVersions[i] = boards[i].version;
+      changed.push_back(i);
+    }
+  }
+
+  // Every board is upscaled from its cells on its own, and boards don't
+  // overlap, so they're drawn at the same time.
+  with_pixel_format(bb.format, [&](auto const format) {
+    pool.for_each(changed.size(), [&](std::size_t const i) {
+      auto const& board = boards[changed[i]];
+      auto const rect = layout.board_rect(changed[i]);
+      CellImage image {{rect.x, rect.y},
+                       layout.cellSize,
+                       {Board::columns, Board::visibleRows},
+                       bb.format};
+      for (int y {0}; y < Board::visibleRows; ++y) {
+        for (int x {0}; x < Board::columns; ++x) {
+          auto const index = static_cast<std::size_t>(y * Board::columns + x);
+          image.fill({x, y}, board.cells[index].color());
+        }
+      }
+      image.template draw<decltype(format)::value>(bb, buffer_rect(bb));
+    });
+  });
+
+  if (redrawAll) {
+    return {buffer_rect(bb)};
+  }
+  std::vector<Rect<int>> rects {};
+  for (auto const i : changed) {
+    if (auto const rect =
+            rect_intersection(layout.board_rect(i), buffer_rect(bb))) {
+      rects.push_back(*rect);
+    }
+  }
+  return rects;
 }
 
 } // namespace SoftwareRender
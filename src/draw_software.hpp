@@ -2,10 +2,26 @@
 
 #include "core.hpp"
 #include "font.hpp"
+#include "spectate.hpp"
+
+#include <cstddef>
+#include <vector>
 
 namespace SoftwareRender {
 
-auto draw(ProgramState& programState, GameState& gameState) -> void;
+// Only redraws the parts of the back buffer that changed since the last frame
+// and returns them.
+auto draw(ProgramState& programState, GameState const& gameState)
+    -> std::vector<Rect<int>>;
+// Draws the spectator wall instead of the game, only redrawing the boards
+// whose version changed since the last time it was drawn, and returns them.
+auto draw_wall(std::vector<Spectate::BoardView> const& boards)
+    -> std::vector<Rect<int>>;
+// Makes the next frame redraw everything.
+auto invalidate() -> void;
+// How many threads frames are drawn on, the calling one included. Defaults to
+// one per hardware thread.
+auto set_thread_count(std::size_t count) -> void;
 
 auto draw_solid_square_normalized(BackBuffer& buf, Rect<double> sqr,
                                   Color::RGBA color) -> void;
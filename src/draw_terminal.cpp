@@ -0,0 +1,175 @@
+#include "draw_terminal.hpp"
+
+#include "draw_software.hpp"
+#include "platform.hpp"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <optional>
+
+namespace TerminalRender {
+
+// Text is black in the software renderer too.
+Rgb constexpr textColor {0, 0, 0};
+
+auto Screen::resize(Rect<int>::Size const size) -> void {
+  m_size = size;
+  auto const cellCount = static_cast<std::size_t>(size.w * size.h);
+  m_cells.assign(cellCount, {});
+  m_shown.assign(cellCount, {});
+  m_showsNothing = true;
+}
+
+auto Screen::cell(int const x, int const y) -> Cell& {
+  assert(x >= 0 and x < m_size.w and y >= 0 and y < m_size.h);
+  return m_cells[static_cast<std::size_t>(y * m_size.w + x)];
+}
+
+auto Screen::present(std::string& output) -> void {
+  auto out = std::back_inserter(output);
+  if (m_showsNothing) {
+    output += "\x1b[0m\x1b[2J";
+  }
+
+  // The cursor moves on by itself and the colors stay set, so they're only
+  // sent when the next changed cell needs them to be different.
+  std::optional<Point<int>> cursor {};
+  std::optional<Rgb> foreground {};
+  std::optional<Rgb> background {};
+  for (int y {0}; y < m_size.h; ++y) {
+    for (int x {0}; x < m_size.w; ++x) {
+      auto const i = static_cast<std::size_t>(y * m_size.w + x);
+      auto const& cell = m_cells[i];
+      if (not m_showsNothing and cell == m_shown[i]) {
+        continue;
+      }
+
+      if (not cursor or cursor->x != x or cursor->y != y) {
+        fmt::format_to(out, "\x1b[{};{}H", y + 1, x + 1);
+      }
+      auto const fg = cell.character ? textColor : cell.top;
+      auto const bg = cell.character ? cell.top : cell.bottom;
+      if (foreground != fg) {
+        fmt::format_to(out, "\x1b[38;2;{};{};{}m", fg.r, fg.g, fg.b);
+        foreground = fg;
+      }
+      if (background != bg) {
+        fmt::format_to(out, "\x1b[48;2;{};{};{}m", bg.r, bg.g, bg.b);
+        background = bg;
+      }
+      if (cell.character) {
+        output += cell.character;
+      } else {
+        // The upper half block, U+2580, in UTF-8.
+        output += "\xe2\x96\x80";
+      }
+
+      // Where the cursor is after the last column depends on the terminal.
+      cursor = x + 1 < m_size.w ? std::optional {Point<int> {x + 1, y}}
+                                : std::nullopt;
+    }
+  }
+
+  m_shown = m_cells;
+  m_showsNothing = false;
+}
+
+namespace {
+
+// Text is drawn after the rest of the frame, centered on its row.
+struct Text {
+  Point<int> center;
+  std::string text;
+};
+
+std::vector<Text> texts {};
+
+} // namespace
+
+auto draw(ProgramState& programState, GameState const& gameState)
+    -> std::string const& {
+  texts.clear();
+  // Cells are compared on their own, so the damage isn't needed.
+  static_cast<void>(SoftwareRender::draw(programState, gameState));
+
+  auto const bb = get_back_buffer();
+  assert(bb.format == PixelFormat::XRGB8888);
+  auto const width = static_cast<int>(uint {bb.dimensions.w});
+  auto const height = static_cast<int>(uint {bb.dimensions.h});
+  static Screen screen {};
+  Rect<int>::Size const size {width, (height + 1) / 2};
+  if (size.w != screen.size().w or size.h != screen.size().h) {
+    screen.resize(size);
+  }
+
+  auto const pixel = [&bb](int const x, int const y) {
+    auto const* const p = static_cast<u8 const*>(bb.memory) +
+                          static_cast<std::size_t>(y) * uint {bb.pitch} +
+                          static_cast<std::size_t>(x) * 4;
+    return Rgb {p[2], p[1], p[0]};
+  };
+  for (int y {0}; y < size.h; ++y) {
+    for (int x {0}; x < size.w; ++x) {
+      screen.cell(x, y) = {pixel(x, y * 2),
+                           pixel(x, std::min(y * 2 + 1, height - 1))};
+    }
+  }
+
+  // Text that would run off the right edge is moved left instead, since
+  // right aligned text is placed by its width in the font.
+  for (auto const& [center, text] : texts) {
+    auto const length = static_cast<int>(text.size());
+    auto const y = std::clamp(center.y / 2, 0, size.h - 1);
+    auto x = std::clamp(center.x, 0, std::max(0, size.w - length));
+    for (auto const c : text) {
+      if (x >= size.w) {
+        break;
+      }
+      screen.cell(x++, y).character = c >= ' ' and c <= '~' ? c : ' ';
+    }
+  }
+
+  static std::string output {};
+  output.clear();
+  screen.present(output);
+  return output;
+}
+
+auto draw_font_string(BackBuffer& /*buf*/, FontString const& fontString,
+                      Point<int> const coords) -> void {
+  std::string text {};
+  for (auto const& fontCharacter : fontString.data) {
+    text += fontCharacter.character;
+  }
+  texts.push_back({coords, std::move(text)});
+}
+
+auto draw_font_string_normalized(BackBuffer& buf, FontString const& fontString,
+                                 Point<double> const relativeCoords) -> void {
+  Point<int> const realCoords {
+      static_cast<int>(relativeCoords.x * uint {buf.dimensions.w}),
+      static_cast<int>(relativeCoords.y * uint {buf.dimensions.h}),
+  };
+  draw_font_string(buf, fontString, realCoords);
+}
+
+auto draw_text(BackBuffer& /*buf*/, std::string_view const text,
+               Point<int> const coords, double const pixelHeight) -> void {
+  texts.push_back({{coords.x, coords.y + static_cast<int>(pixelHeight / 2)},
+                   std::string {text}});
+}
+
+auto draw_text_normalized(BackBuffer& buf, std::string_view const text,
+                          Point<double> const relativeCoords,
+                          double const pixelHeight) -> void {
+  Point<int> const realCoords {
+      static_cast<int>(relativeCoords.x * uint {buf.dimensions.w}),
+      static_cast<int>(relativeCoords.y * uint {buf.dimensions.h}),
+  };
+  draw_text(buf, text, realCoords, pixelHeight * uint {buf.dimensions.h});
+}
+
+} // namespace TerminalRender
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "core.hpp"
+#include "font.hpp"
+#include "util.hpp"
+
+#include "jint.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Draws frames in a terminal. The software renderer draws the frame at a
+// small scale, and every character cell shows two of its pixels stacked on
+// top of each other as a half block in 24 bit color. Text is drawn as plain
+// characters instead, since it would be unreadable at that scale.
+namespace TerminalRender {
+
+struct Rgb {
+  u8 r;
+  u8 g;
+  u8 b;
+
+  [[nodiscard]] auto friend operator==(Rgb const& lhs, Rgb const& rhs)
+      -> bool {
+    return lhs.r == rhs.r and lhs.g == rhs.g and lhs.b == rhs.b;
+  }
+  [[nodiscard]] auto friend operator!=(Rgb const& lhs, Rgb const& rhs)
+      -> bool {
+    return not(lhs == rhs);
+  }
+};
+
+// Either a half block in the top color over the bottom color, or a character
+// in the text color over the top color.
+struct Cell {
+  Rgb top {};
+  Rgb bottom {};
+  char character {'\0'};
+
+  [[nodiscard]] auto friend operator==(Cell const& lhs, Cell const& rhs)
+      -> bool {
+    return lhs.top == rhs.top and lhs.bottom == rhs.bottom and
+           lhs.character == rhs.character;
+  }
+  [[nodiscard]] auto friend operator!=(Cell const& lhs, Cell const& rhs)
+      -> bool {
+    return not(lhs == rhs);
+  }
+};
+
+// The cells of a frame, and the cells the terminal is showing.
+class Screen {
+public:
+  // All of the next frame is sent, since the terminal's contents are no
+  // longer known.
+  auto resize(Rect<int>::Size size) -> void;
+  [[nodiscard]] auto size() const -> Rect<int>::Size { return m_size; }
+  [[nodiscard]] auto cell(int x, int y) -> Cell&;
+
+  // Appends the escape sequences that turn what the terminal shows into the
+  // frame, only touching the cells that changed, and remembers the frame as
+  // shown.
+  auto present(std::string& output) -> void;
+
+private:
+  Rect<int>::Size m_size {};
+  std::vector<Cell> m_cells {};
+  std::vector<Cell> m_shown {};
+  bool m_showsNothing {true};
+};
+
+// Returns the escape sequences that draw the frame over the last one.
+auto draw(ProgramState& programState, GameState const& gameState)
+    -> std::string const&;
+
+// Text is drawn over everything else in the frame.
+auto draw_font_string(BackBuffer& buf, FontString const& fontString,
+                      Point<int> coords) -> void;
+auto draw_font_string_normalized(BackBuffer& buf, FontString const& fontString,
+                                 Point<double> relativeCoords) -> void;
+auto draw_text(BackBuffer& buf, std::string_view text, Point<int> coords,
+               double pixelHeight) -> void;
+auto draw_text_normalized(BackBuffer& buf, std::string_view text,
+                          Point<double> relativeCoords, double pixelHeight)
+    -> void;
+
+} // namespace TerminalRender
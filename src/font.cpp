@@ -12,6 +12,9 @@ uchar static ttf_buffer[1 << 25];
 stbtt_fontinfo font;
 BakedChars static bakedChars;
 BakedCharsBitmap bakedCharsBitmap {};
+// The baked characters are the printable ASCII ones.
+auto constexpr firstChar = 32;
+auto constexpr charCount = static_cast<int>(BakedChars {}.size());
 
 // FIXME: Temporary implementation. Should probably use std::path or something.
 //        Also the path shouldn't be relative to the current working directory.
@@ -27,11 +30,8 @@ auto init_font(std::string const& fontName) -> bool {
   stbtt_InitFont(&font, ttf_buffer,
                  stbtt_GetFontOffsetForIndex(&(*ttf_buffer), 0));
 
-  auto constexpr fontHeight = 32;
   auto constexpr offset = 0;
-  auto constexpr firstChar = 32;
-  auto constexpr charCount = 96;
-  stbtt_BakeFontBitmap(ttf_buffer, offset, fontHeight,
+  stbtt_BakeFontBitmap(ttf_buffer, offset, BakedCharsBitmap::pixelHeight,
                        bakedCharsBitmap.bitmap.data(), bakedCharsBitmap.w,
                        bakedCharsBitmap.h, firstChar, charCount,
                        bakedChars.data());
@@ -71,8 +71,46 @@ auto get_baked_chars_bitmap() -> BakedCharsBitmap const& {
   return bakedCharsBitmap;
 }
 
+auto append_baked_quads(std::string_view const text, double const pixelHeight,
+                        Point<double> const coords,
+                        std::vector<stbtt_aligned_quad>& quads) -> void {
+  auto const scale = static_cast<double>(
+      stbtt_ScaleForPixelHeight(&font, static_cast<float>(pixelHeight)));
+  int ascent {};
+  stbtt_GetFontVMetrics(&font, &ascent, nullptr, nullptr);
+  // The baked quads are as big as the characters were baked, and grow with
+  // the pixel height like the characters' outlines do.
+  auto const bakedScale = pixelHeight / BakedCharsBitmap::pixelHeight;
+  auto const baseline = coords.y + ascent * scale;
+
+  auto x = coords.x;
+  auto const size = text.size();
+  for (std::size_t i {0}; i < size; ++i) {
+    auto const c = text[i];
+    auto const nextChar = i + 1 == size ? '\0' : text[i + 1];
+    auto const index = static_cast<int>(static_cast<uchar>(c)) - firstChar;
+    if (index >= 0 and index < charCount) {
+      float penX {0.F};
+      float penY {0.F};
+      stbtt_aligned_quad quad {};
+      stbtt_GetBakedQuad(bakedChars.data(), BakedCharsBitmap::w,
+                         BakedCharsBitmap::h, index, &penX, &penY, &quad, 1);
+      // Spaces and the like don't have anything to draw.
+      if (quad.x1 > quad.x0 and quad.y1 > quad.y0) {
+        quad.x0 = static_cast<float>(x + quad.x0 * bakedScale);
+        quad.x1 = static_cast<float>(x + quad.x1 * bakedScale);
+        quad.y0 = static_cast<float>(baseline + quad.y0 * bakedScale);
+        quad.y1 = static_cast<float>(baseline + quad.y1 * bakedScale);
+        quads.push_back(quad);
+      }
+    }
+    x += get_codepoint_kern_advance(c, nextChar, scale);
+  }
+}
+
 FontString::FontString(std::string_view const string,
-                       double const pixelHeight) {
+                       double const desiredPixelHeight)
+    : pixelHeight {desiredPixelHeight} {
   auto w = 0.;
 
   auto const size = string.size();
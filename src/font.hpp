@@ -38,14 +38,25 @@ using BakedChars = std::array<stbtt_bakedchar, 96>;
 struct BakedCharsBitmap {
   auto constexpr static w = 512;
   auto constexpr static h = 512;
+  // How high the characters are baked, in pixels.
+  auto constexpr static pixelHeight = 32;
   std::array<uchar, w * h> bitmap;
 };
 [[nodiscard]] auto get_baked_chars_bitmap() -> BakedCharsBitmap const&;
 
+// Lays `text` out like a FontString of it that's `pixelHeight` pixels high,
+// with its top left corner at `coords`, and adds a quad of the baked
+// characters for every character that shows up. The quads' texture
+// coordinates are normalized to the baked bitmap.
+auto append_baked_quads(std::string_view text, double pixelHeight,
+                        Point<double> coords,
+                        std::vector<stbtt_aligned_quad>& quads) -> void;
+
 class FontString {
 public:
   std::vector<FontCharacter> data;
   Rect<double>::Size normalizedDimensions;
+  double pixelHeight;
 
   [[nodiscard]] auto static from_width(std::string_view string,
                                        double desiredPixelWidth) -> FontString;
@@ -64,7 +75,7 @@ public:
       std::string_view text, double fontHeightNormalized) -> double;
 
 private:
-  FontString(std::string_view string, double pixelHeight);
+  FontString(std::string_view string, double desiredPixelHeight);
 };
 
 auto init_font(std::string const& fontName) -> bool;
@@ -0,0 +1,504 @@
+#include "game.hpp"
+
+#include "core.hpp"
+#include "rangealgorithms.hpp"
+
+#include "fmt/core.h"
+
+#include <cassert>
+#include <exception>
+#include <stdexcept>
+#include <string_view>
+
+// scoring formula (https://harddrop.com/wiki/Scoring):
+// Single:             100 x level
+// Double:             300 x level
+// Triple:             500 x level
+// Tetris:             800 x level
+// T-Spin:             400 x level
+// T-Spin Single:      800 x level
+// T-Spin Double:      1200 x level
+// T-Spin Triple:      1600 x level
+// T-Spin Mini:        100 x level
+// T-Spin Mini Single: 200 x level
+// T-Spin Mini Double: 1200 x level
+//
+// Back to Back Tetris/T-Spin: * 1.5 (e.g. back to back tetris: 1200 x level)
+// Combo:     50 x combo count x level
+// Soft drop: 1 point per cell
+// Hard drop: 2 point per cell
+//
+// Softdropping.
+// dropcount needs to be reset when:
+//     A new shape is introduced, i.e. shape lock or hold.
+//     the soft drop button is released, but not if the shape is on ground.
+//     If the shape falls at all when the soft drop button is not pressed.
+//     If the shape is moved when it's grounded or is rotated with a kick while
+//     grounded If the shape is hard dropped (and actually moves from it)
+
+auto static clear_type_to_score(ClearType const c) -> int {
+  auto constexpr None = 0;
+  auto constexpr Single = 100;
+  auto constexpr Double = 300;
+  auto constexpr Triple = 500;
+  auto constexpr Tetris = 800;
+  auto constexpr Tspin = 400;
+  auto constexpr Tspin_single = 800;
+  auto constexpr Tspin_double = 1200;
+  auto constexpr Tspin_triple = 1600;
+  auto constexpr Tspin_mini = 100;
+  auto constexpr Tspin_mini_single = 200;
+  auto constexpr Tspin_mini_double = 1200;
+
+  switch (c) {
+  case ClearType::None:
+    return None;
+  case ClearType::Single:
+    return Single;
+  case ClearType::Double:
+    return Double;
+  case ClearType::Triple:
+    return Triple;
+  case ClearType::Tetris:
+    return Tetris;
+  case ClearType::Tspin:
+    return Tspin;
+  case ClearType::Tspin_single:
+    return Tspin_single;
+  case ClearType::Tspin_double:
+    return Tspin_double;
+  case ClearType::Tspin_triple:
+    return Tspin_triple;
+  case ClearType::Tspin_mini:
+    return Tspin_mini;
+  case ClearType::Tspin_mini_single:
+    return Tspin_mini_single;
+  case ClearType::Tspin_mini_double:
+    return Tspin_mini_double;
+  }
+  // Unreachable.
+  std::terminate();
+}
+
+auto to_string_view(ClearType const c) -> std::string_view {
+  switch (c) {
+  case ClearType::None:
+    return "";
+  case ClearType::Single:
+    return "Single";
+  case ClearType::Double:
+    return "Double";
+  case ClearType::Triple:
+    return "Triple";
+  case ClearType::Tetris:
+    return "Tetris";
+  case ClearType::Tspin:
+    return "Tspin";
+  case ClearType::Tspin_single:
+    return "Tspin_single";
+  case ClearType::Tspin_double:
+    return "Tspin_double";
+  case ClearType::Tspin_triple:
+    return "Tspin_triple";
+  case ClearType::Tspin_mini:
+    return "Tspin_mini";
+  case ClearType::Tspin_mini_single:
+    return "Tspin_mini_single";
+  case ClearType::Tspin_mini_double:
+    return "Tspin_mini_double";
+  }
+  // Unreachable.
+  std::terminate();
+}
+
+[[nodiscard]] auto static get_clear_type(int const rowsCleared,
+                                         std::optional<TspinType> const tspin) {
+  auto bad_row_count_msg = [rowsCleared](std::size_t min, std::size_t max) {
+    return fmt::format("The amount of rows cleared should be between {} and "
+                       "{}, but is currently {}",
+                       min, max, rowsCleared);
+  };
+
+  if (not tspin) {
+    switch (rowsCleared) {
+    case 0:
+      return ClearType::None;
+    case 1:
+      return ClearType::Single;
+    case 2:
+      return ClearType::Double;
+    case 3:
+      return ClearType::Triple;
+    case 4:
+      return ClearType::Tetris;
+    default:
+      auto const errMsg = bad_row_count_msg(0, 4);
+      throw std::invalid_argument(errMsg);
+    }
+  }
+
+  if (*tspin == TspinType::Mini) {
+    switch (rowsCleared) {
+    case 0:
+      return ClearType::Tspin_mini;
+    case 1:
+      return ClearType::Tspin_mini_single;
+    case 2:
+      return ClearType::Tspin_mini_double;
+    case 3:
+      // T-spin triple requires a wallkick so there is no
+      // distinction between regular and mini (although it's
+      // going to be represented internally as a mini).
+      return ClearType::Tspin_triple;
+    default:
+      auto errMsg = bad_row_count_msg(0, 3);
+      throw std::invalid_argument(errMsg);
+    }
+  }
+
+  switch (rowsCleared) {
+  case 0:
+    return ClearType::Tspin;
+  case 1:
+    return ClearType::Tspin_single;
+  case 2:
+    return ClearType::Tspin_double;
+  case 3:
+    return ClearType::Tspin_triple;
+  default:
+    auto errMsg = bad_row_count_msg(0, 3);
+    throw std::invalid_argument(errMsg);
+  }
+}
+
+[[nodiscard]] auto static calculate_score(ClearType const clearType,
+                                          int const level) {
+  return clear_type_to_score(clearType) * level;
+}
+
+// Keeps the previewed shapes generated, since the renderers can only read
+// the pool.
+[[nodiscard]] auto static next_shape(GameState& gameState) -> Shape {
+  auto const shape = gameState.shapePool.next_shape();
+  gameState.shapePool.generate_ahead(gPreviewShapeCount);
+  return shape;
+}
+
+auto static lock_current_shape(GameState& gameState,
+                               GameClock::time_point const now) -> LockResult {
+  LockResult result {};
+
+  // game over if entire piece is above visible portion
+  // of board
+  auto const shapePositions =
+      gameState.currentShape.get_absolute_block_positions();
+  result.gameOver = all_of(shapePositions, [](auto const& pos) {
+    return pos.y < (Board::rows - Board::visibleRows);
+  });
+
+  // fix currentBlocks position on board
+  for (auto const position : shapePositions) {
+    assert(gameState.board.is_valid_spot(position));
+    gsl::index index {position.y * gameState.board.columns + position.x};
+    gameState.board.block_at(index) =
+        Block::from(gameState.currentShape.type());
+  }
+
+  auto const tspin =
+      gameState.currentRotationType
+          ? gameState.board.check_for_tspin(gameState.currentShape,
+                                            *gameState.currentRotationType)
+          : std::nullopt;
+
+  auto const rowsCleared = gameState.board.remove_full_rows();
+  gameState.linesCleared += rowsCleared;
+  auto const clearType = get_clear_type(rowsCleared, tspin);
+  result.clearType = clearType;
+  result.rowsCleared = rowsCleared;
+
+  // only regular clears count, but if it's a t-spin then
+  // droppedRows should have been set to 0 from rotating the shape
+  // so it SHOULDN'T be necessary to check explicitly.
+  if (clearType != ClearType::None) {
+    // you shouldn't be able to soft drop and hard drop at the same
+    // time.
+    assert(not gameState.droppedRows or not gameState.softDropRowCount);
+    gameState.score += 2 * gameState.droppedRows;
+    gameState.score += gameState.softDropRowCount;
+  }
+  // needs to be reset for the next piece
+  gameState.softDropRowCount = 0;
+  gameState.droppedRows = 0;
+
+  // handle combos
+  switch (clearType) {
+  case ClearType::Single:
+  case ClearType::Double:
+  case ClearType::Triple:
+  case ClearType::Tetris:
+  case ClearType::Tspin_single:
+  case ClearType::Tspin_double:
+  case ClearType::Tspin_triple:
+  case ClearType::Tspin_mini_single:
+  case ClearType::Tspin_mini_double: {
+    ++gameState.comboCounter;
+    result.comboScore = 50 * gameState.comboCounter * gameState.level;
+    gameState.score += result.comboScore;
+  } break;
+    // These aren't technically clears and will reset your combo
+  case ClearType::None:
+  case ClearType::Tspin:
+  case ClearType::Tspin_mini: {
+    gameState.comboCounter = -1;
+  } break;
+  }
+  result.comboCounter = gameState.comboCounter;
+
+  // check for back to back tetris/t-spin
+  switch (clearType) {
+  case ClearType::Tetris: {
+    if (gameState.backToBackType == BackToBackType::Tetris) {
+      result.backToBack = true;
+    } else {
+      gameState.backToBackType = BackToBackType::Tetris;
+    }
+  } break;
+  case ClearType::Tspin:
+  case ClearType::Tspin_mini:
+  case ClearType::Tspin_single:
+  case ClearType::Tspin_mini_single:
+  case ClearType::Tspin_double:
+  case ClearType::Tspin_mini_double:
+  case ClearType::Tspin_triple: {
+    if (gameState.backToBackType == BackToBackType::Tspin) {
+      result.backToBack = true;
+    } else {
+      gameState.backToBackType = BackToBackType::Tspin;
+    }
+  } break;
+  case ClearType::None:
+  case ClearType::Single:
+  case ClearType::Double:
+  case ClearType::Triple: {
+    gameState.backToBackType = std::nullopt;
+  } break;
+  }
+
+  auto const backToBackModifier = result.backToBack ? 1.5 : 1.0;
+  auto clearScore = static_cast<int>(
+      calculate_score(clearType, gameState.level) * backToBackModifier);
+  gameState.score += clearScore;
+
+  gameState.level = gameState.linesCleared / 10 + gameState.startingLevel;
+
+  gameState.currentShape = next_shape(gameState);
+  // update shape shadow
+  gameState.currentShapeShadow =
+      gameState.board.get_shadow(gameState.currentShape);
+
+  gameState.lockClock = now;
+
+  gameState.hasHeld = false;
+
+  // game over if the new shape spawned on top of another shape
+  if (not gameState.board.is_valid_shape(gameState.currentShape)) {
+    result.gameOver = true;
+  }
+
+  if (result.gameOver) {
+    gameState.gameOver = true;
+  }
+
+  return result;
+}
+
+auto static update_shadow_and_clocks(GameState& gameState,
+                                     GameClock::time_point const now,
+                                     bool const isGrounded) {
+  gameState.currentShapeShadow =
+      gameState.board.get_shadow(gameState.currentShape);
+  gameState.lockClock = now;
+  if (isGrounded) {
+    gameState.dropClock = now;
+  }
+}
+
+auto move_current_shape(GameState& gameState, V2 const dir,
+                        GameClock::time_point const now) -> void {
+  // if currentShape is on top of a block before move,
+  // the drop clock needs to be reset
+  auto const isGrounded =
+      not gameState.board.is_valid_move(gameState.currentShape, V2::down());
+  if (gameState.board.try_move(gameState.currentShape, dir)) {
+    update_shadow_and_clocks(gameState, now, isGrounded);
+    // if you move the piece you cancel the drop
+    gameState.droppedRows = 0;
+    if (isGrounded) {
+      gameState.softDropRowCount = 0;
+    }
+  }
+}
+
+auto rotate_current_shape(GameState& gameState,
+                          Shape::RotationDirection const dir,
+                          GameClock::time_point const now) -> void {
+  // if currentShape is on top of a block before rotation,
+  // the drop clock needs to be reset
+  auto const isGrounded =
+      not gameState.board.is_valid_move(gameState.currentShape, V2::down());
+  if (auto const rotation =
+          gameState.board.rotate_shape(gameState.currentShape, dir)) {
+    update_shadow_and_clocks(gameState, now, isGrounded);
+    gameState.currentRotationType = rotation;
+    // if you rotate the piece you cancel the drop
+    gameState.droppedRows = 0;
+    if ((rotation == Shape::RotationType::Wallkick) and isGrounded) {
+      gameState.softDropRowCount = 0;
+    }
+  }
+}
+
+auto hard_drop(GameState& gameState, GameClock::time_point const now) -> void {
+  auto droppedRows = 0;
+  while (gameState.board.try_move(gameState.currentShape, V2::down())) {
+    gameState.lockClock = now;
+    gameState.currentRotationType = std::nullopt;
+    ++droppedRows;
+  }
+  gameState.droppedRows = droppedRows;
+
+  // hard drop overrides soft drop
+  if (droppedRows) {
+    gameState.softDropRowCount = 0;
+  }
+}
+
+auto start_soft_drop(GameState& gameState) -> void {
+  // TODO: How does this work if you e.g. press
+  // left/right/rotate while holding button down?
+  // is isSoftDropping still true at that time?
+
+  // The soft drop event currently gets spammed when you hold down
+  // the button, so resetting the soft drop count directly
+  // will continue resetting it while the button is pressed.
+  // In order to avoid that we check if isSoftDropping has
+  // been set, which only happens during spam.
+  if (not gameState.isSoftDropping) {
+    gameState.softDropRowCount = 0;
+  }
+  gameState.isSoftDropping = true;
+}
+
+auto stop_soft_drop(GameState& gameState) -> void {
+  gameState.isSoftDropping = false;
+
+  // softdrops only get reset if the piece can currently fall
+  if (gameState.board.is_valid_move(gameState.currentShape, V2::down())) {
+    gameState.softDropRowCount = 0;
+  }
+}
+
+auto hold_current_shape(GameState& gameState, GameClock::time_point const now)
+    -> void {
+  if (gameState.hasHeld) {
+    return;
+  }
+
+  gameState.hasHeld = true;
+  gameState.currentRotationType = std::nullopt;
+  if (gameState.holdShapeType) {
+    auto const holdType = *gameState.holdShapeType;
+
+    gameState.holdShapeType = gameState.currentShape.type();
+    gameState.currentShape = Shape {holdType};
+  } else {
+    gameState.holdShapeType = gameState.currentShape.type();
+    gameState.currentShape = next_shape(gameState);
+  }
+
+  gameState.softDropRowCount = 0;
+  gameState.droppedRows = 0;
+
+  // game over if the new shape spawned on top of another shape
+  if (not gameState.board.is_valid_shape(gameState.currentShape)) {
+    gameState.gameOver = true;
+  }
+
+  auto const isGrounded =
+      not gameState.board.is_valid_move(gameState.currentShape, V2::down());
+  update_shadow_and_clocks(gameState, now, isGrounded);
+}
+
+auto apply_input(GameState& gameState, Input const input,
+                 GameClock::time_point const now) -> void {
+  using Action = Input::Action;
+
+  if (input.has(Action::Hold)) {
+    hold_current_shape(gameState, now);
+  }
+  if (input.has(Action::Rotate_left)) {
+    rotate_current_shape(gameState, Shape::RotationDirection::Left, now);
+  }
+  if (input.has(Action::Rotate_right)) {
+    rotate_current_shape(gameState, Shape::RotationDirection::Right, now);
+  }
+  if (input.has(Action::Move_left)) {
+    move_current_shape(gameState, V2::left(), now);
+  }
+  if (input.has(Action::Move_right)) {
+    move_current_shape(gameState, V2::right(), now);
+  }
+  if (input.has(Action::Soft_drop)) {
+    start_soft_drop(gameState);
+  } else if (gameState.isSoftDropping) {
+    stop_soft_drop(gameState);
+  }
+  if (input.has(Action::Drop)) {
+    hard_drop(gameState, now);
+  }
+}
+
+auto update_game(GameState& gameState, GameClock::time_point const now)
+    -> std::optional<LockResult> {
+  if (gameState.gameOver) {
+    return std::nullopt;
+  }
+
+  auto const dropDelay = [&]() {
+    auto const levelDropDelay = gameState.drop_delay_for_level();
+    if (gameState.isSoftDropping and
+        (GameState::softDropDelay < levelDropDelay)) {
+      return GameState::softDropDelay;
+    } else {
+      return levelDropDelay;
+    }
+  }();
+
+  // TODO: make it possible for shapes to drop more than one block
+  // (e.g. at max drop speed it should drop all the way to the bottom
+  // instantly)
+  auto const nextdropClock = gameState.dropClock + dropDelay;
+  if (now > nextdropClock) {
+    gameState.dropClock = now;
+    if (gameState.board.try_move(gameState.currentShape, V2::down())) {
+      gameState.lockClock = now;
+      gameState.currentRotationType = std::nullopt;
+
+      if (gameState.isSoftDropping) {
+        ++gameState.softDropRowCount;
+      } else {
+        gameState.softDropRowCount = 0;
+      }
+    }
+  }
+
+  if (now > gameState.lockClock + GameState::lockDelay) {
+    // only care about locking if currentShape is on top of a block
+    if (not gameState.board.is_valid_move(gameState.currentShape,
+                                          V2::down())) {
+      return lock_current_shape(gameState, now);
+    }
+  }
+
+  return std::nullopt;
+}
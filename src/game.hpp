@@ -0,0 +1,113 @@
+#pragma once
+
+#include "core.hpp"
+#include "shape.hpp"
+#include "util.hpp"
+
+#include "jint.h"
+
+#include <optional>
+#include <string_view>
+
+// The rules of a single game, independent of where its input comes from and
+// of how it's presented. Every function takes the current time explicitly so
+// that games can be driven by a deterministic clock as well as the wall clock.
+
+enum class ClearType {
+  None,
+  Single,
+  Double,
+  Triple,
+  Tetris,
+
+  Tspin,
+  Tspin_single,
+  Tspin_double,
+  Tspin_triple,
+  Tspin_mini,
+  Tspin_mini_single,
+  Tspin_mini_double,
+};
+
+[[nodiscard]] auto to_string_view(ClearType c) -> std::string_view;
+
+// What happened when a shape was locked into the board.
+struct LockResult {
+  ClearType clearType {ClearType::None};
+  u8 rowsCleared {0};
+  int comboCounter {-1};
+  int comboScore {0};
+  bool backToBack {false};
+  bool gameOver {false};
+};
+
+// Everything a player can do during a single tick, packed into a bit set so a
+// tick's input is cheap to store and send.
+class Input {
+public:
+  enum class Action : u8 {
+    Move_left,
+    Move_right,
+    Rotate_left,
+    Rotate_right,
+    Drop,
+    Hold,
+    // Held rather than pressed, i.e. soft dropping continues for as long as
+    // the action is set.
+    Soft_drop,
+  };
+
+  Input() noexcept = default;
+  explicit constexpr Input(u8 const bits) noexcept : m_bits {bits} {}
+
+  auto constexpr set(Action const action) noexcept -> Input& {
+    m_bits = static_cast<u8>(m_bits | mask(action));
+    return *this;
+  }
+  [[nodiscard]] auto constexpr has(Action const action) const noexcept
+      -> bool {
+    return (m_bits & mask(action)) != 0;
+  }
+  [[nodiscard]] auto constexpr bits() const noexcept -> u8 { return m_bits; }
+
+  [[nodiscard]] auto constexpr friend operator==(Input const& lhs,
+                                                 Input const& rhs) {
+    return lhs.m_bits == rhs.m_bits;
+  }
+  [[nodiscard]] auto constexpr friend operator!=(Input const& lhs,
+                                                 Input const& rhs) {
+    return lhs.m_bits != rhs.m_bits;
+  }
+
+  template <typename Archive>
+  auto serialize(Archive& archive) -> void {
+    archive(m_bits);
+  }
+
+private:
+  [[nodiscard]] auto static constexpr mask(Action const action) noexcept
+      -> u8 {
+    return static_cast<u8>(1U << static_cast<u8>(action));
+  }
+
+  u8 m_bits {0};
+};
+
+using GameClock = GameState::HiResClock;
+
+auto move_current_shape(GameState& gameState, V2 dir, GameClock::time_point now)
+    -> void;
+auto rotate_current_shape(GameState& gameState, Shape::RotationDirection dir,
+                          GameClock::time_point now) -> void;
+auto hard_drop(GameState& gameState, GameClock::time_point now) -> void;
+auto start_soft_drop(GameState& gameState) -> void;
+auto stop_soft_drop(GameState& gameState) -> void;
+auto hold_current_shape(GameState& gameState, GameClock::time_point now)
+    -> void;
+auto apply_input(GameState& gameState, Input input, GameClock::time_point now)
+    -> void;
+
+// Drops the current shape if it's time to, and locks it once it has been
+// resting on something for long enough.
+auto update_game(GameState& gameState, GameClock::time_point now)
+    -> std::optional<LockResult>;
@@ -1,10 +1,16 @@
 #include "sdlmain.hpp"
 
+#include "../bench.hpp"
+#include "../capture.hpp"
 #include "../core.hpp"
 #include "../font.hpp"
 #include "../input.hpp"
 #include "../platform.hpp"
+#include "../rollback.hpp"
+#include "../spectate.hpp"
 #include "../util.hpp"
+#include "../versus.hpp"
+#include "terminal.hpp"
 
 #include "../jint.h"
 
@@ -12,9 +18,16 @@
 #include <SDL_opengl.h>
 #include <glad/glad.h> // must be included before SDL
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <optional>
+#include <string>
 #include <string_view>
+#include <vector>
 
 namespace platform::SDL {
 
@@ -23,10 +36,36 @@ auto windowScale = 1;
 struct {
   SDL_Window* handle {};
   SDL_Surface* surface {};
+  // Only used if the software renderer can't draw into the window surface
+  // directly.
   SDL_Surface* bbSurface {};
   Rect<int>::Size dimensions {};
+  // Set when the window's contents were lost, e.g. while it was covered.
+  bool needsFullUpdate {true};
 } window {};
 
+// Offscreen frames are drawn into memory rather than a window, so they can
+// be rendered without a display, and the chosen ones are written out as
+// images.
+struct {
+  std::vector<u8> pixels {};
+  u64 frameCount {0};
+  u64 frame {0};
+  std::vector<u64> dumpedFrames {};
+  bool quitSent {false};
+} offscreen {};
+
+std::optional<platform::Terminal> terminal {};
+
+// Terminals only report key presses, so a soft drop stops once Down hasn't
+// been repeated for a while.
+struct TerminalInput {
+  using Clock = std::chrono::steady_clock;
+  Clock::duration static constexpr release {std::chrono::milliseconds {250}};
+  bool softDropping {false};
+  Clock::time_point lastSoftDrop {};
+} terminalInput {};
+
 SDL_GLContext g_glContext {};
 
 OpenGLRender::Context static* context = nullptr;
@@ -38,13 +77,63 @@ auto get_render_mode() -> RenderMode { return g_renderMode; }
 auto get_gl_context() -> SDL_GLContext { return g_glContext; }
 auto get_window_scale() -> int { return windowScale; }
 
+[[nodiscard]] auto static to_pixel_format(Uint32 const format)
+    -> std::optional<PixelFormat> {
+  switch (format) {
+  case SDL_PIXELFORMAT_RGB888:
+    return PixelFormat::XRGB8888;
+  case SDL_PIXELFORMAT_ARGB8888:
+    return PixelFormat::ARGB8888;
+  case SDL_PIXELFORMAT_RGB565:
+    return PixelFormat::RGB565;
+  case SDL_PIXELFORMAT_BGR24:
+    return PixelFormat::BGR24;
+  default:
+    return std::nullopt;
+  }
+}
+
+// The software renderer draws straight into the window surface if it can
+// draw in its format, so presenting a frame doesn't copy it. Otherwise it
+// draws into a separate back buffer, which is converted when it's blitted to
+// the window.
+auto static recreate_back_buffer_surface() -> void {
+  SDL_FreeSurface(window.bbSurface);
+  window.bbSurface = nullptr;
+  if (to_pixel_format(window.surface->format->format) and
+      not SDL_MUSTLOCK(window.surface)) {
+    return;
+  }
+
+  window.bbSurface = SDL_CreateRGBSurfaceWithFormat(
+      0, window.surface->w, window.surface->h,
+      SDL_BITSPERPIXEL(SDL_PIXELFORMAT_RGB888), SDL_PIXELFORMAT_RGB888);
+  assert(window.bbSurface);
+}
+
 auto get_back_buffer() -> BackBuffer {
+  if (get_render_mode() == RenderMode::offscreen or
+      get_render_mode() == RenderMode::terminal) {
+    auto constexpr format = PixelFormat::XRGB8888;
+    auto bbuf = BackBuffer {};
+    bbuf.memory = offscreen.pixels.data();
+    bbuf.dimensions = {PositiveUInt {window.dimensions.w},
+                       PositiveUInt {window.dimensions.h}};
+    bbuf.pitch =
+        PositiveUInt {window.dimensions.w * int {bytes_per_pixel(format)}};
+    bbuf.bpp = bytes_per_pixel(format);
+    bbuf.format = format;
+    return bbuf;
+  }
+
+  auto const* const surface =
+      window.bbSurface ? window.bbSurface : window.surface;
   auto bbuf = BackBuffer {};
-  bbuf.memory = window.bbSurface->pixels;
-  bbuf.dimensions = {PositiveUInt {window.bbSurface->w},
-                     PositiveUInt {window.bbSurface->h}};
-  bbuf.pitch = PositiveUInt {window.bbSurface->pitch};
-  bbuf.bpp = window.bbSurface->format->BytesPerPixel;
+  bbuf.memory = surface->pixels;
+  bbuf.dimensions = {PositiveUInt {surface->w}, PositiveUInt {surface->h}};
+  bbuf.pitch = PositiveUInt {surface->pitch};
+  bbuf.bpp = surface->format->BytesPerPixel;
+  bbuf.format = *to_pixel_format(surface->format->format);
 
   return bbuf;
 }
@@ -53,19 +142,25 @@ auto get_window_dimensions() -> Rect<int>::Size { return window.dimensions; }
 
 auto static resize_window(Rect<int>::Size const dimensions) {
   window.dimensions = dimensions;
-  SDL_SetWindowSize(window.handle, dimensions.w, dimensions.h);
-  window.surface = SDL_GetWindowSurface(window.handle);
-  assert(window.surface);
-  SDL_FreeSurface(window.bbSurface);
-  window.bbSurface = SDL_CreateRGBSurface(
-      0, window.surface->w, window.surface->h,
-      window.surface->format->BitsPerPixel, window.surface->format->Rmask,
-      window.surface->format->Gmask, window.surface->format->Bmask,
-      window.surface->format->Amask);
-  assert(window.bbSurface);
-
-  if (get_render_mode() == RenderMode::opengl) {
+  switch (get_render_mode()) {
+  case RenderMode::software: {
+    SDL_SetWindowSize(window.handle, dimensions.w, dimensions.h);
+    window.surface = SDL_GetWindowSurface(window.handle);
+    assert(window.surface);
+    recreate_back_buffer_surface();
+    window.needsFullUpdate = true;
+  } break;
+  case RenderMode::opengl: {
+    // A window that is drawn to with OpenGL can't have a surface.
+    SDL_SetWindowSize(window.handle, dimensions.w, dimensions.h);
     glViewport(0, 0, window.dimensions.w, window.dimensions.h);
+  } break;
+  case RenderMode::offscreen:
+  case RenderMode::terminal: {
+    offscreen.pixels.resize(static_cast<std::size_t>(
+        dimensions.w * dimensions.h *
+        bytes_per_pixel(PixelFormat::XRGB8888)));
+  } break;
   }
 }
 
@@ -81,16 +176,93 @@ auto change_window_scale(int newScale) -> void {
       {gBaseWindowWidth * windowScale, gBaseWindowHeight * windowScale});
 }
 
+// Writes the offscreen back buffer as a binary PPM.
+auto static write_ppm(std::string const& path) -> bool {
+  std::ofstream file {path, std::ios::binary};
+  file << "P6\n" << window.dimensions.w << ' ' << window.dimensions.h
+       << "\n255\n";
+  auto const bb = get_back_buffer();
+  std::vector<char> row(static_cast<std::size_t>(window.dimensions.w * 3));
+  for (int y {0}; y < window.dimensions.h; ++y) {
+    auto const* pixel = static_cast<u8 const*>(bb.memory) +
+                        static_cast<std::size_t>(y) * uint {bb.pitch};
+    for (std::size_t x {0}; x < row.size(); x += 3, pixel += 4) {
+      // XRGB8888 is stored as BGRX.
+      row[x] = static_cast<char>(pixel[2]);
+      row[x + 1] = static_cast<char>(pixel[1]);
+      row[x + 2] = static_cast<char>(pixel[0]);
+    }
+    file.write(row.data(), static_cast<std::streamsize>(row.size()));
+  }
+  return static_cast<bool>(file);
+}
+
+auto static present_offscreen_frame() -> void {
+  auto const& dumped = offscreen.dumpedFrames;
+  if (std::find(dumped.begin(), dumped.end(), offscreen.frame) !=
+      dumped.end()) {
+    auto const path = "frame_" + std::to_string(offscreen.frame) + ".ppm";
+    if (not write_ppm(path)) {
+      std::fprintf(stderr, "Couldn't write %s\n", path.c_str());
+    }
+  }
+  ++offscreen.frame;
+}
+
 auto swap_buffer() -> void {
   switch (get_render_mode()) {
   case RenderMode::software: {
-    SDL_BlitSurface(window.bbSurface, nullptr, window.surface, nullptr);
+    if (window.bbSurface) {
+      SDL_BlitSurface(window.bbSurface, nullptr, window.surface, nullptr);
+    }
     SDL_UpdateWindowSurface(window.handle);
   } break;
   case RenderMode::opengl: {
     SDL_GL_SwapWindow(window.handle);
   } break;
+  case RenderMode::offscreen: {
+    present_offscreen_frame();
+  } break;
+  case RenderMode::terminal: {
+    // Terminal frames are presented with present_terminal_frame().
+  } break;
+  }
+}
+
+auto present_terminal_frame(std::string_view const escapeSequences) -> void {
+  terminal->write(escapeSequences);
+}
+
+auto swap_buffer(std::vector<Rect<int>> const& damagedRects) -> void {
+  assert(get_render_mode() == RenderMode::software or
+         get_render_mode() == RenderMode::offscreen);
+  if (get_render_mode() == RenderMode::offscreen) {
+    present_offscreen_frame();
+    return;
+  }
+  if (window.needsFullUpdate) {
+    window.needsFullUpdate = false;
+    swap_buffer();
+    return;
+  }
+  if (damagedRects.empty()) {
+    return;
   }
+
+  std::vector<SDL_Rect> rects {};
+  rects.reserve(damagedRects.size());
+  for (auto const& damagedRect : damagedRects) {
+    SDL_Rect const rect {damagedRect.x, damagedRect.y, damagedRect.w,
+                         damagedRect.h};
+    if (window.bbSurface) {
+      // Blitting clips the destination rect it's given.
+      auto destination = rect;
+      SDL_BlitSurface(window.bbSurface, &rect, window.surface, &destination);
+    }
+    rects.push_back(rect);
+  }
+  SDL_UpdateWindowSurfaceRects(window.handle, rects.data(),
+                               static_cast<int>(rects.size()));
 }
 
 auto static window_fits_on_screen(Rect<int>::Size windowDimensions) -> bool {
@@ -101,8 +273,123 @@ auto static window_fits_on_screen(Rect<int>::Size windowDimensions) -> bool {
          windowDimensions.h < displayBounds.h;
 }
 
+// Reads a number typed into the terminal and the byte after it.
+auto static read_terminal_number() -> std::pair<int, char> {
+  int number {0};
+  while (auto const byte = terminal->read_byte()) {
+    if (*byte < '0' or *byte > '9') {
+      return {number, *byte};
+    }
+    number = number * 10 + (*byte - '0');
+  }
+  return {number, '\0'};
+}
+
+// Escape sequences are typed all at once, so a lone escape is the Escape key.
+auto static get_terminal_escape_sequence() -> Event {
+  Event event {};
+  auto const introducer = terminal->read_byte();
+  if (not introducer) {
+    event.type = Event::Type::Pause;
+    return event;
+  }
+  if (*introducer != '[') {
+    return event;
+  }
+
+  switch (terminal->read_byte().value_or('\0')) {
+  case 'A': {
+    event.type = Event::Type::Drop;
+  } break;
+  case 'B': {
+    event.type = Event::Type::Increase_speed;
+    terminalInput.softDropping = true;
+    terminalInput.lastSoftDrop = TerminalInput::Clock::now();
+  } break;
+  case 'C': {
+    event.type = Event::Type::Move_right;
+  } break;
+  case 'D': {
+    event.type = Event::Type::Move_left;
+  } break;
+  case '<': {
+    // A mouse event, as "button;column;row" ending in M when it's pressed.
+    auto const [button, afterButton] = read_terminal_number();
+    auto const [column, afterColumn] = read_terminal_number();
+    auto const [row, end] = read_terminal_number();
+    if (button == 0 and end == 'M') {
+      event.type = Event::Type::Mousebuttondown;
+      // Every cell is a pixel wide and two pixels tall.
+      event.mouseCoords = {column - 1, (row - 1) * 2};
+    }
+  } break;
+  default: {
+  } break;
+  }
+  return event;
+}
+
+auto static get_terminal_event() -> Event {
+  Event event {};
+  auto const byte = terminal->read_byte();
+  if (not byte) {
+    if (terminalInput.softDropping and
+        TerminalInput::Clock::now() - terminalInput.lastSoftDrop >
+            TerminalInput::release) {
+      terminalInput.softDropping = false;
+      event.type = Event::Type::Reset_speed;
+    }
+    return event;
+  }
+
+  switch (*byte) {
+  // Ctrl-C.
+  case '\x03':
+  case 'q': {
+    event.type = Event::Type::Quit;
+  } break;
+  case '\x1b': {
+    event = get_terminal_escape_sequence();
+  } break;
+  case 'r': {
+    event.type = Event::Type::Reset;
+  } break;
+  case 'z': {
+    event.type = Event::Type::Rotate_left;
+  } break;
+  case 'x': {
+    event.type = Event::Type::Rotate_right;
+  } break;
+  case '2': {
+    event.type = Event::Type::Increase_window_size;
+  } break;
+  case '1': {
+    event.type = Event::Type::Decrease_window_size;
+  } break;
+  case ' ': {
+    event.type = Event::Type::Hold;
+  } break;
+  default: {
+  } break;
+  }
+  return event;
+}
+
 auto get_event() -> Event {
   Event event {};
+  if (get_render_mode() == RenderMode::terminal) {
+    return get_terminal_event();
+  }
+  if (get_render_mode() == RenderMode::offscreen) {
+    // There's no one to give input, so the game just plays until it has
+    // rendered all of its frames.
+    if (offscreen.frame >= offscreen.frameCount and not offscreen.quitSent) {
+      offscreen.quitSent = true;
+      event.type = Event::Type::Quit;
+    }
+    return event;
+  }
+
   SDL_Event e;
   if (SDL_PollEvent(&e)) {
     if (e.type == SDL_QUIT) {
@@ -151,6 +438,9 @@ auto get_event() -> Event {
         event.type = Event::Type::Reset_speed;
       } break;
       }
+    } else if (e.type == SDL_WINDOWEVENT and
+               e.window.event == SDL_WINDOWEVENT_EXPOSED) {
+      window.needsFullUpdate = true;
     } else if (e.type == SDL_MOUSEBUTTONDOWN) {
       if (e.button.button == SDL_BUTTON_LEFT) {
         event.type = Event::Type::Mousebuttondown;
@@ -162,9 +452,10 @@ auto get_event() -> Event {
   return event;
 }
 
-auto init_window_opengl() {
+// Returns whether the window and its OpenGL context could be created.
+auto static create_opengl_window(Uint32 const flags) -> bool {
   if (SDL_Init(SDL_INIT_EVERYTHING) < 0) {
-    throw;
+    return false;
   }
 
   SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
@@ -175,22 +466,32 @@ auto init_window_opengl() {
   window.dimensions = {gBaseWindowWidth * windowScale,
                        gBaseWindowHeight * windowScale};
 
-  window.handle = SDL_CreateWindow("Tetris", SDL_WINDOWPOS_UNDEFINED,
-                                   SDL_WINDOWPOS_UNDEFINED, window.dimensions.w,
-                                   window.dimensions.h,
-                                   SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN);
-  assert(window.handle);
+  window.handle = SDL_CreateWindow(
+      "Tetris", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+      window.dimensions.w, window.dimensions.h, SDL_WINDOW_OPENGL | flags);
+  if (not window.handle) {
+    return false;
+  }
 
   g_glContext = SDL_GL_CreateContext(window.handle);
-  assert(g_glContext);
+  if (not g_glContext) {
+    return false;
+  }
 
   if (gladLoadGLLoader(static_cast<GLADloadproc>(SDL_GL_GetProcAddress)) == 0) {
-    throw;
+    return false;
   }
 
   glViewport(0, 0, window.dimensions.w, window.dimensions.h);
   glEnable(GL_BLEND);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  return true;
+}
+
+auto init_window_opengl() {
+  if (not create_opengl_window(SDL_WINDOW_SHOWN)) {
+    throw;
+  }
 }
 
 auto init_window_software() {
@@ -219,15 +520,28 @@ auto init_window_software() {
   window.surface = SDL_GetWindowSurface(window.handle);
   assert(window.surface);
 
-  window.bbSurface = SDL_CreateRGBSurface(
-      0, window.surface->w, window.surface->h,
-      window.surface->format->BitsPerPixel, window.surface->format->Rmask,
-      window.surface->format->Gmask, window.surface->format->Bmask,
-      window.surface->format->Amask);
-  assert(window.bbSurface);
+  recreate_back_buffer_surface();
 }
 
-auto static init_window(RenderMode renderMode) {
+// The window is only pretend, so its scale is whatever fits the chosen size.
+auto init_window_offscreen(Rect<int>::Size const dimensions) {
+  windowScale = std::max(1, std::min(dimensions.w / gBaseWindowWidth,
+                                     dimensions.h / gBaseWindowHeight));
+  resize_window(dimensions);
+}
+
+// Picks the biggest scale that fits in the terminal, with two pixels in
+// every cell.
+auto static init_window_terminal() {
+  auto const cells = terminal->size();
+  windowScale = std::max(1, std::min(cells.w / gBaseWindowWidth,
+                                     cells.h * 2 / gBaseWindowHeight));
+  resize_window(
+      {gBaseWindowWidth * windowScale, gBaseWindowHeight * windowScale});
+}
+
+auto static init_window(RenderMode renderMode,
+                        Rect<int>::Size const offscreenDimensions) {
   switch (renderMode) {
   case RenderMode::opengl: {
     init_window_opengl();
@@ -235,22 +549,41 @@ auto static init_window(RenderMode renderMode) {
   case RenderMode::software: {
     init_window_software();
   } break;
+  case RenderMode::offscreen: {
+    init_window_offscreen(offscreenDimensions);
+  } break;
+  case RenderMode::terminal: {
+    init_window_terminal();
+  } break;
   }
 }
 
 auto static destroy_window() {
-  SDL_DestroyWindow(window.handle);
+  terminal.reset();
+  if (window.handle) {
+    SDL_DestroyWindow(window.handle);
+  }
   window.handle = nullptr;
   SDL_Quit();
 }
 
-auto get_opengl_render_context() -> OpenGLRender::Context const& {
+auto get_opengl_render_context() -> OpenGLRender::Context& {
   return *context;
 }
 
+auto get_opengl_proc_address(char const* const name) -> void* {
+  return SDL_GL_GetProcAddress(name);
+}
+
 } // namespace platform::SDL
 
 auto main(int argc, char** argv) -> int {
+  std::optional<int> headlessMatchCount {};
+  std::optional<Rollback::NetplayConfig> netplayConfig {};
+  Rect<int>::Size offscreenDimensions {};
+  auto benchmark = false;
+  std::optional<std::string> capturePath {};
+  std::optional<std::size_t> spectatedBoards {};
   for (int i = 1; i < argc; ++i) {
     std::string_view arg {argv[i]};
     using namespace std::string_view_literals;
@@ -258,22 +591,123 @@ auto main(int argc, char** argv) -> int {
       g_renderMode = RenderMode::opengl;
     } else if (arg == "-software"sv) {
       g_renderMode = RenderMode::software;
+    } else if (arg == "-terminal"sv) {
+      g_renderMode = RenderMode::terminal;
+    } else if (arg == "-offscreen"sv and i + 3 < argc) {
+      g_renderMode = RenderMode::offscreen;
+      offscreenDimensions.w = std::max(1, std::atoi(argv[++i]));
+      offscreenDimensions.h = std::max(1, std::atoi(argv[++i]));
+      offscreen.frameCount =
+          static_cast<u64>(std::max(0, std::atoi(argv[++i])));
+    } else if (arg == "-dump"sv and i + 1 < argc) {
+      offscreen.dumpedFrames.push_back(
+          static_cast<u64>(std::max(0, std::atoi(argv[++i]))));
+    } else if (arg == "-capture"sv and i + 1 < argc) {
+      capturePath = argv[++i];
+    } else if (arg == "-spectate"sv and i + 1 < argc) {
+      spectatedBoards = static_cast<std::size_t>(
+          std::clamp(std::atoi(argv[++i]), 1,
+                     static_cast<int>(Spectate::maxBoards)));
+    } else if (arg == "-bench"sv) {
+      benchmark = true;
+    } else if (arg == "-versus"sv and i + 1 < argc) {
+      headlessMatchCount = std::atoi(argv[++i]);
+    } else if (arg == "-netplay"sv and i + 2 < argc) {
+      netplayConfig = netplayConfig.value_or(Rollback::NetplayConfig {});
+      netplayConfig->localPort = static_cast<u16>(std::atoi(argv[++i]));
+      netplayConfig->remotePort = static_cast<u16>(std::atoi(argv[++i]));
+    } else if (arg == "-delay"sv and i + 1 < argc) {
+      netplayConfig = netplayConfig.value_or(Rollback::NetplayConfig {});
+      netplayConfig->inputDelay = static_cast<u64>(std::atoi(argv[++i]));
+    } else if (arg == "-latency"sv and i + 1 < argc) {
+      netplayConfig = netplayConfig.value_or(Rollback::NetplayConfig {});
+      netplayConfig->latency = std::chrono::milliseconds {std::atoi(argv[++i])};
+    } else if (arg == "-ticks"sv and i + 1 < argc) {
+      netplayConfig = netplayConfig.value_or(Rollback::NetplayConfig {});
+      netplayConfig->ticks = static_cast<u64>(std::atoi(argv[++i]));
     }
   }
 
-  init_window(g_renderMode);
+  if (headlessMatchCount) {
+    Versus::run_headless_tournament(*headlessMatchCount);
+    return 0;
+  }
+
+  if (netplayConfig) {
+    return Rollback::run_netplay(*netplayConfig) ? 0 : 1;
+  }
+
+  if (benchmark) {
+    if (not init_font("DejaVuSans.ttf")) {
+      return 1;
+    }
+
+    g_renderMode = RenderMode::offscreen;
+    init_window(g_renderMode, {gBaseWindowWidth, gBaseWindowHeight});
+    Bench::run_software();
+
+    // The OpenGL renderer is only measured if there's a display to create a
+    // context on.
+    g_renderMode = RenderMode::opengl;
+    if (create_opengl_window(SDL_WINDOW_HIDDEN)) {
+      OpenGLRender::Context benchContext {};
+      context = &benchContext;
+      Bench::run_opengl();
+      context = nullptr;
+    } else {
+      std::fprintf(stderr, "Skipping the OpenGL renderer: %s\n",
+                   SDL_GetError());
+    }
+    platform::SDL::destroy_window();
+    return 0;
+  }
+
+  // The wall is only drawn by the software renderer.
+  if (spectatedBoards and g_renderMode != RenderMode::offscreen) {
+    g_renderMode = RenderMode::software;
+  }
+
+  if (g_renderMode == RenderMode::terminal) {
+    terminal = platform::Terminal::open();
+    if (not terminal) {
+      std::fprintf(stderr, "-terminal has to be run in a terminal\n");
+      return 1;
+    }
+  }
+
+  // The font has to be baked before the OpenGL context uploads it.
+  if (not init_font("DejaVuSans.ttf")) {
+    assert(false);
+    return 1;
+  }
+
+  init_window(g_renderMode, offscreenDimensions);
   std::optional<OpenGLRender::Context> openglRenderContext = std::nullopt;
   if (g_renderMode == RenderMode::opengl) {
     openglRenderContext = OpenGLRender::Context {};
     context = &(*openglRenderContext);
   }
 
-  if (not init_font("DejaVuSans.ttf")) {
-    assert(false);
-    return 1;
+  if (capturePath) {
+    // Offscreen frames are made as fast as possible, so the game waits for
+    // the recorder instead of dropping them.
+    auto const blocking = g_renderMode == RenderMode::offscreen;
+    if (g_renderMode == RenderMode::opengl or
+        g_renderMode == RenderMode::terminal) {
+      std::fprintf(stderr, "Capturing needs the software renderer\n");
+    } else if (not Capture::start(*capturePath, blocking)) {
+      std::fprintf(stderr, "Couldn't create %s\n", capturePath->c_str());
+      return 1;
+    }
+  }
+
+  if (spectatedBoards) {
+    Spectate::run(*spectatedBoards);
+  } else {
+    run();
   }
 
-  run();
+  Capture::stop();
 
   platform::SDL::destroy_window();
 
@@ -12,15 +12,26 @@
 
 namespace platform::SDL {
 
-enum class RenderMode { software, opengl };
+// Offscreen renders like software, but into memory instead of a window.
+// Terminal renders like software too, at a small scale, and then shows the
+// pixels as characters in the terminal it was started from.
+enum class RenderMode { software, opengl, offscreen, terminal };
 
 auto swap_buffer() -> void;
+// Only presents the given parts of the back buffer, in software and
+// offscreen mode.
+auto swap_buffer(std::vector<Rect<int>> const& damagedRects) -> void;
+// Shows a frame drawn by the terminal renderer.
+auto present_terminal_frame(std::string_view escapeSequences) -> void;
 auto get_back_buffer() -> BackBuffer;
 auto get_window_scale() -> int;
 auto change_window_scale(int) -> void;
 auto get_window_dimensions() -> Rect<int>::Size;
 auto get_event() -> Event;
 auto get_render_mode() -> RenderMode;
-auto get_opengl_render_context() -> OpenGLRender::Context const&;
+auto get_opengl_render_context() -> OpenGLRender::Context&;
+// Looks up OpenGL functions that aren't part of the 3.3 core profile glad
+// loads, e.g. ones from extensions. Returns null if there's no such function.
+auto get_opengl_proc_address(char const* name) -> void*;
 
 } // namespace platform::SDL
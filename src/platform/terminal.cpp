@@ -0,0 +1,139 @@
+#include "terminal.hpp"
+
+#include <cstdio>
+#include <utility>
+
+#if not defined(_WIN32)
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+namespace platform {
+
+using namespace std::string_view_literals;
+
+// Switches to the alternate screen, hides the cursor and reports mouse
+// clicks in cells.
+auto constexpr enterSequence = "\x1b[?1049h\x1b[?25l\x1b[?1000h\x1b[?1006h"sv;
+auto constexpr leaveSequence = "\x1b[?1006l\x1b[?1000l\x1b[0m\x1b[?25h"
+                               "\x1b[?1049l"sv;
+
+Terminal::Terminal(Terminal&& other) noexcept
+    : m_tty {std::exchange(other.m_tty, -1)},
+      m_savedStdout {std::exchange(other.m_savedStdout, -1)},
+      m_savedStderr {std::exchange(other.m_savedStderr, -1)} {
+#if not defined(_WIN32)
+  m_original = other.m_original;
+#endif
+}
+
+auto Terminal::operator=(Terminal&& other) noexcept -> Terminal& {
+  std::swap(m_tty, other.m_tty);
+  std::swap(m_savedStdout, other.m_savedStdout);
+  std::swap(m_savedStderr, other.m_savedStderr);
+#if not defined(_WIN32)
+  std::swap(m_original, other.m_original);
+#endif
+  return *this;
+}
+
+Terminal::~Terminal() { close(); }
+
+#if defined(_WIN32)
+
+auto Terminal::open() -> std::optional<Terminal> { return {}; }
+auto Terminal::close() -> void {}
+auto Terminal::size() const -> Rect<int>::Size { return {}; }
+auto Terminal::read_byte() -> std::optional<char> { return {}; }
+auto Terminal::write(std::string_view /*bytes*/) -> void {}
+
+#else
+
+auto Terminal::open() -> std::optional<Terminal> {
+  auto const tty = ::open("/dev/tty", O_RDWR | O_NOCTTY);
+  if (tty < 0) {
+    return {};
+  }
+  termios original {};
+  if (tcgetattr(tty, &original) != 0) {
+    ::close(tty);
+    return {};
+  }
+
+  // Ctrl-C is read like any other key, so the terminal is always restored.
+  auto raw = original;
+  raw.c_lflag &= ~static_cast<tcflag_t>(ICANON | ECHO | ISIG);
+  raw.c_cc[VMIN] = 0;
+  raw.c_cc[VTIME] = 0;
+  if (tcsetattr(tty, TCSANOW, &raw) != 0) {
+    ::close(tty);
+    return {};
+  }
+
+  Terminal terminal {};
+  terminal.m_tty = tty;
+  terminal.m_original = original;
+
+  std::fflush(stdout);
+  std::fflush(stderr);
+  terminal.m_savedStdout = dup(STDOUT_FILENO);
+  terminal.m_savedStderr = dup(STDERR_FILENO);
+  auto const null = ::open("/dev/null", O_WRONLY);
+  dup2(null, STDOUT_FILENO);
+  dup2(null, STDERR_FILENO);
+  ::close(null);
+
+  terminal.write(enterSequence);
+  return terminal;
+}
+
+auto Terminal::close() -> void {
+  if (m_tty < 0) {
+    return;
+  }
+  write(leaveSequence);
+  tcsetattr(m_tty, TCSANOW, &m_original);
+  ::close(std::exchange(m_tty, -1));
+
+  std::fflush(stdout);
+  std::fflush(stderr);
+  for (auto const& [saved, original] :
+       {std::pair {&m_savedStdout, STDOUT_FILENO},
+        std::pair {&m_savedStderr, STDERR_FILENO}}) {
+    if (*saved >= 0) {
+      dup2(*saved, original);
+      ::close(std::exchange(*saved, -1));
+    }
+  }
+}
+
+auto Terminal::size() const -> Rect<int>::Size {
+  winsize size {};
+  if (ioctl(m_tty, TIOCGWINSZ, &size) != 0) {
+    return {};
+  }
+  return {size.ws_col, size.ws_row};
+}
+
+auto Terminal::read_byte() -> std::optional<char> {
+  char byte {};
+  if (read(m_tty, &byte, 1) != 1) {
+    return {};
+  }
+  return byte;
+}
+
+auto Terminal::write(std::string_view bytes) -> void {
+  while (not bytes.empty()) {
+    auto const written = ::write(m_tty, bytes.data(), bytes.size());
+    if (written <= 0) {
+      return;
+    }
+    bytes.remove_prefix(static_cast<std::size_t>(written));
+  }
+}
+
+#endif
+
+} // namespace platform
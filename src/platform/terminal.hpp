@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../util.hpp"
+
+#include <optional>
+#include <string_view>
+
+#if not defined(_WIN32)
+#include <termios.h>
+#endif
+
+namespace platform {
+
+// The terminal the game is played in, with input read a byte at a time as
+// it's typed instead of a line at a time, and without echoing it. Drawing
+// happens on the terminal's alternate screen, so whatever was on it before
+// comes back when it's closed. While it's open, anything printed to stdout or
+// stderr is thrown away, since it would end up in the middle of the frame.
+class Terminal {
+public:
+  // Returns nothing if there's no terminal to open, e.g. on platforms without
+  // one.
+  [[nodiscard]] auto static open() -> std::optional<Terminal>;
+
+  Terminal(Terminal const&) = delete;
+  auto operator=(Terminal const&) -> Terminal& = delete;
+  Terminal(Terminal&& other) noexcept;
+  auto operator=(Terminal&& other) noexcept -> Terminal&;
+  ~Terminal();
+
+  // In character cells.
+  [[nodiscard]] auto size() const -> Rect<int>::Size;
+  // Returns nothing if there is no input waiting.
+  [[nodiscard]] auto read_byte() -> std::optional<char>;
+  // Writes all of the bytes at once.
+  auto write(std::string_view bytes) -> void;
+
+private:
+  Terminal() = default;
+  auto close() -> void;
+
+  int m_tty {-1};
+  int m_savedStdout {-1};
+  int m_savedStderr {-1};
+#if not defined(_WIN32)
+  termios m_original {};
+#endif
+};
+
+} // namespace platform
@@ -0,0 +1,114 @@
+#include "udp.hpp"
+
+#include <cstring>
+#include <utility>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace platform {
+
+#if defined(_WIN32)
+using NativeSocket = SOCKET;
+#else
+using NativeSocket = int;
+#endif
+
+auto static loopback_address(u16 const port) -> sockaddr_in {
+  sockaddr_in address {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  return address;
+}
+
+auto static close_socket(NativeSocket const socket) {
+#if defined(_WIN32)
+  closesocket(socket);
+#else
+  close(socket);
+#endif
+}
+
+auto UdpSocket::open(u16 const port) -> std::optional<UdpSocket> {
+#if defined(_WIN32)
+  WSADATA wsaData {};
+  if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+    return {};
+  }
+#endif
+
+  auto const native = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#if defined(_WIN32)
+  if (native == INVALID_SOCKET) {
+    return {};
+  }
+#else
+  if (native < 0) {
+    return {};
+  }
+#endif
+
+  auto const address = loopback_address(port);
+  auto const bound =
+      bind(native, reinterpret_cast<sockaddr const*>(&address),
+           sizeof(address)) == 0;
+#if defined(_WIN32)
+  u_long nonBlocking {1};
+  auto const madeNonBlocking = ioctlsocket(native, FIONBIO, &nonBlocking) == 0;
+#else
+  auto const madeNonBlocking =
+      fcntl(native, F_SETFL, fcntl(native, F_GETFL, 0) | O_NONBLOCK) == 0;
+#endif
+  if (not bound or not madeNonBlocking) {
+    close_socket(native);
+    return {};
+  }
+
+  return UdpSocket {static_cast<Handle>(native)};
+}
+
+UdpSocket::UdpSocket(UdpSocket&& other) noexcept
+    : m_handle {std::exchange(other.m_handle, invalidHandle)} {}
+
+auto UdpSocket::operator=(UdpSocket&& other) noexcept -> UdpSocket& {
+  std::swap(m_handle, other.m_handle);
+  return *this;
+}
+
+UdpSocket::~UdpSocket() {
+  if (m_handle != invalidHandle) {
+    close_socket(static_cast<NativeSocket>(m_handle));
+  }
+}
+
+auto UdpSocket::send_to(u16 const port, gsl::span<u8 const> const bytes)
+    -> void {
+  auto const address = loopback_address(port);
+  sendto(static_cast<NativeSocket>(m_handle),
+         reinterpret_cast<char const*>(bytes.data()),
+         static_cast<int>(bytes.size()), 0,
+         reinterpret_cast<sockaddr const*>(&address), sizeof(address));
+}
+
+auto UdpSocket::receive(gsl::span<u8> const buffer)
+    -> std::optional<std::size_t> {
+  auto const received =
+      recv(static_cast<NativeSocket>(m_handle),
+           reinterpret_cast<char*>(buffer.data()),
+           static_cast<int>(buffer.size()), 0);
+  if (received < 0) {
+    return {};
+  }
+  return static_cast<std::size_t>(received);
+}
+
+} // namespace platform
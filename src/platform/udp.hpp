@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../jint.h"
+
+#include <gsl/gsl>
+
+#include <cstdint>
+#include <optional>
+
+namespace platform {
+
+// A non-blocking UDP socket bound to the loopback interface.
+class UdpSocket {
+public:
+  // Returns nothing if the port couldn't be bound.
+  [[nodiscard]] auto static open(u16 port) -> std::optional<UdpSocket>;
+
+  UdpSocket(UdpSocket const&) = delete;
+  auto operator=(UdpSocket const&) -> UdpSocket& = delete;
+  UdpSocket(UdpSocket&& other) noexcept;
+  auto operator=(UdpSocket&& other) noexcept -> UdpSocket&;
+  ~UdpSocket();
+
+  // Sends a datagram to the port on the loopback interface. Datagrams that
+  // can't be sent right away are dropped, like any other lost packet.
+  auto send_to(u16 port, gsl::span<u8 const> bytes) -> void;
+  // Returns the size of the datagram written into the buffer, or nothing if
+  // there is no datagram waiting.
+  [[nodiscard]] auto receive(gsl::span<u8> buffer) -> std::optional<std::size_t>;
+
+private:
+  using Handle = std::intptr_t;
+  explicit UdpSocket(Handle handle) noexcept : m_handle {handle} {}
+
+  Handle static constexpr invalidHandle {-1};
+  Handle m_handle {invalidHandle};
+};
+
+} // namespace platform
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <iterator>
 
 template <typename Container, typename UnaryPredicate>
 [[nodiscard]] auto constexpr count_if(Container& c, UnaryPredicate const& p) {
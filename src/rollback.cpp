@@ -0,0 +1,381 @@
+#include "rollback.hpp"
+
+#include "platform/udp.hpp"
+#include "snapshot.hpp"
+
+#include "fmt/core.h"
+
+#include <cassert>
+#include <deque>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Rollback {
+
+// Matches can't be default constructed, so the array is filled with copies as
+// it's constructed.
+template <std::size_t... i>
+[[nodiscard]] auto static copies_of(Match const& match,
+                                    std::index_sequence<i...> /*indices*/)
+    -> std::array<Match, sizeof...(i)> {
+  return {((void)i, match)...};
+}
+
+Session::Session(Match const& match, std::size_t const localPlayer,
+                 u64 const inputDelay)
+    : m_match {match}, m_localPlayer {localPlayer},
+      m_inputDelay {std::min(inputDelay, maxInputDelay)},
+      m_states {copies_of(match, std::make_index_sequence<stateCapacity> {})},
+      m_remoteConfirmed {match.tick()}, m_nextChecksumTick {match.tick()} {
+  assert(localPlayer < 2);
+  // Nobody can press anything during the first delayed ticks.
+  for (auto tick = match.tick(); tick < local_input_end(); ++tick) {
+    m_localInputs[tick % inputCapacity] = {tick, Input {}};
+  }
+}
+
+auto Session::can_advance() const -> bool {
+  return m_match.tick() < m_remoteConfirmed + maxPrediction;
+}
+
+auto Session::advance(Input const localInput) -> void {
+  assert(can_advance());
+  resimulate();
+
+  auto const inputTick = local_input_end();
+  m_localInputs[inputTick % inputCapacity] = {inputTick, localInput};
+  step();
+  record_checksums();
+}
+
+auto Session::resimulate() -> void {
+  if (not m_rollbackTick) {
+    return;
+  }
+
+  auto const start = std::chrono::steady_clock::now();
+  auto const from = *m_rollbackTick;
+  auto const to = m_match.tick();
+  assert(to - from < stateCapacity);
+  m_rollbackTick.reset();
+
+  m_match = m_states[from % stateCapacity];
+  while (m_match.tick() < to) {
+    step();
+  }
+
+  ++m_stats.rollbacks;
+  m_stats.resimulatedTicks += to - from;
+  m_stats.maxRollbackDepth = std::max(m_stats.maxRollbackDepth, to - from);
+  m_stats.maxRollbackTime =
+      std::max(m_stats.maxRollbackTime,
+               std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now() - start));
+  record_checksums();
+}
+
+auto Session::add_remote_input(u64 const tick, Input const input) -> void {
+  if (tick < m_remoteConfirmed or tick >= m_remoteConfirmed + inputCapacity) {
+    return;
+  }
+  auto& slot = m_remoteInputs[tick % inputCapacity];
+  if (slot.tick == tick) {
+    return;
+  }
+  slot = {tick, input};
+
+  auto const& used = m_usedRemoteInputs[tick % inputCapacity];
+  if (tick < m_match.tick() and used.tick == tick and used.input != input) {
+    m_rollbackTick = std::min(m_rollbackTick.value_or(tick), tick);
+  }
+
+  while (m_remoteInputs[m_remoteConfirmed % inputCapacity].tick ==
+         m_remoteConfirmed) {
+    ++m_remoteConfirmed;
+  }
+}
+
+auto Session::add_remote_checksum(u64 const tick, u64 const checksum)
+    -> void {
+  if (tick % checksumInterval != 0) {
+    return;
+  }
+  m_remoteChecksums[(tick / checksumInterval) % checksumCapacity] = {
+      tick, checksum};
+  compare_checksums(tick);
+}
+
+auto Session::local_input(u64 const tick) const -> std::optional<Input> {
+  auto const& slot = m_localInputs[tick % inputCapacity];
+  if (slot.tick != tick) {
+    return {};
+  }
+  return slot.input;
+}
+
+auto Session::latest_checksum() const -> std::optional<std::pair<u64, u64>> {
+  // Wraps around to a tick that can't be found if nothing was recorded yet.
+  auto const tick = m_nextChecksumTick - checksumInterval;
+  auto const& checksum =
+      m_localChecksums[(tick / checksumInterval) % checksumCapacity];
+  if (checksum.tick != tick) {
+    return {};
+  }
+  return std::pair {checksum.tick, checksum.value};
+}
+
+// Buttons that were pressed on the last confirmed tick were most likely
+// released since, but a held soft drop most likely still is, so only that is
+// repeated.
+auto Session::predicted_remote_input(u64 const tick) const -> Input {
+  Input predicted {};
+  if (m_remoteConfirmed == 0 or tick < m_remoteConfirmed) {
+    return predicted;
+  }
+  auto const& last = m_remoteInputs[(m_remoteConfirmed - 1) % inputCapacity];
+  if (last.tick == m_remoteConfirmed - 1 and
+      last.input.has(Input::Action::Soft_drop)) {
+    predicted.set(Input::Action::Soft_drop);
+  }
+  return predicted;
+}
+
+auto Session::inputs_for(u64 const tick) -> Match::Inputs {
+  auto const local = local_input(tick);
+  assert(local);
+
+  auto const& received = m_remoteInputs[tick % inputCapacity];
+  auto const remote =
+      received.tick == tick ? received.input : predicted_remote_input(tick);
+  m_usedRemoteInputs[tick % inputCapacity] = {tick, remote};
+
+  Match::Inputs inputs {};
+  inputs[m_localPlayer] = *local;
+  inputs[1 - m_localPlayer] = remote;
+  return inputs;
+}
+
+auto Session::step() -> void {
+  auto const tick = m_match.tick();
+  m_states[tick % stateCapacity] = m_match;
+  m_match.step(inputs_for(tick));
+}
+
+// Only ticks whose inputs are all confirmed are checksummed, since both peers
+// have to agree on them.
+auto Session::record_checksums() -> void {
+  while (m_nextChecksumTick <= confirmed_tick()) {
+    auto const tick = m_nextChecksumTick;
+    assert(m_match.tick() - tick < stateCapacity);
+    auto const& state = tick == m_match.tick()
+                            ? m_match
+                            : m_states[tick % stateCapacity];
+    m_localChecksums[(tick / checksumInterval) % checksumCapacity] = {
+        tick, Snapshot::checksum(state)};
+    compare_checksums(tick);
+    m_nextChecksumTick += checksumInterval;
+  }
+}
+
+auto Session::compare_checksums(u64 const tick) -> void {
+  auto const index = (tick / checksumInterval) % checksumCapacity;
+  auto const& local = m_localChecksums[index];
+  auto const& remote = m_remoteChecksums[index];
+  if (local.tick == tick and remote.tick == tick and
+      local.value != remote.value and not m_desyncTick) {
+    m_desyncTick = tick;
+  }
+}
+
+namespace {
+
+u32 constexpr packetMagic {0x5344'4E50}; // SDNP
+std::size_t constexpr maxInputsPerPacket {Session::inputCapacity};
+
+// Every packet carries all of the sender's inputs that haven't been
+// acknowledged yet, so lost packets don't need to be detected and resent.
+struct Packet {
+  u32 magic {packetMagic};
+  // The first remote input the sender hasn't received.
+  u64 ack {0};
+  u64 tick {0};
+  // How many ticks the sender thinks it's ahead of the receiver.
+  s32 advantage {0};
+  u64 firstInputTick {0};
+  u8 inputCount {0};
+  std::array<Input, maxInputsPerPacket> inputs {};
+  bool hasChecksum {false};
+  u64 checksumTick {0};
+  u64 checksum {0};
+
+  template <typename Archive>
+  auto serialize(Archive& archive) -> void {
+    archive(magic, ack, tick, advantage, firstInputTick, inputCount);
+    inputCount = std::min(inputCount, u8 {maxInputsPerPacket});
+    for (std::size_t i {0}; i < inputCount; ++i) {
+      archive(inputs[i]);
+    }
+    archive(hasChecksum, checksumTick, checksum);
+  }
+};
+
+// Holds on to packets for a while before sending them.
+class LatentSender {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  LatentSender(platform::UdpSocket& socket, u16 const port,
+               std::chrono::milliseconds const latency)
+      : m_socket {socket}, m_port {port}, m_latency {latency} {}
+
+  auto send(std::vector<u8> bytes, Clock::time_point const now) -> void {
+    m_queue.push_back({now + m_latency, std::move(bytes)});
+    flush(now);
+  }
+
+  auto flush(Clock::time_point const now) -> void {
+    while (not m_queue.empty() and m_queue.front().first <= now) {
+      m_socket.send_to(m_port, m_queue.front().second);
+      m_queue.pop_front();
+    }
+  }
+
+private:
+  platform::UdpSocket& m_socket;
+  u16 m_port;
+  std::chrono::milliseconds m_latency;
+  std::deque<std::pair<Clock::time_point, std::vector<u8>>> m_queue {};
+};
+
+auto constexpr netplayLevel = 5;
+Randomizer::Engine::result_type constexpr netplaySeed {2020};
+
+} // namespace
+
+auto run_netplay(NetplayConfig const& config) -> bool {
+  auto socket = platform::UdpSocket::open(config.localPort);
+  if (not socket) {
+    fmt::print(stderr, "Couldn't bind port {}.\n", config.localPort);
+    return false;
+  }
+
+  // Both peers have to agree on who is who without talking first.
+  std::size_t const localPlayer {config.localPort < config.remotePort ? 0U
+                                                                      : 1U};
+  Session session {Match {netplayLevel, netplaySeed}, localPlayer,
+                   config.inputDelay};
+  Versus::RandomBot bot {netplaySeed + localPlayer};
+  LatentSender sender {*socket, config.remotePort, config.latency};
+
+  using Clock = LatentSender::Clock;
+  u64 remoteAck {0};
+  u64 remoteTick {0};
+  s32 remoteAdvantage {0};
+  u64 stalls {0};
+  std::optional<Clock::time_point> doneTime {};
+  // Keep sending for a while after finishing, since the remote peer might
+  // still need some of our inputs.
+  auto constexpr lingerTime = std::chrono::seconds {1};
+  auto const frameTime = std::chrono::duration_cast<Clock::duration>(
+      ProgramState::targetFrameTime);
+
+  fmt::print("Player {} on port {}, playing {} ticks against port {} with "
+             "{} ticks of input delay and {}ms of added latency.\n",
+             localPlayer + 1, config.localPort, config.ticks, config.remotePort,
+             session.local_input_end() - session.match().tick(),
+             config.latency.count());
+
+  auto nextFrame = Clock::now();
+  for (;;) {
+    auto const now = Clock::now();
+
+    std::array<u8, 1024> buffer {};
+    while (auto const size = socket->receive(buffer)) {
+      Snapshot::Reader reader {gsl::span<u8 const> {buffer}.first(
+          static_cast<gsl::index>(*size))};
+      Packet packet {};
+      reader(packet);
+      if (reader.failed() or packet.magic != packetMagic) {
+        continue;
+      }
+      remoteAck = std::max(remoteAck, packet.ack);
+      if (packet.tick >= remoteTick) {
+        remoteTick = packet.tick;
+        remoteAdvantage = packet.advantage;
+      }
+      for (std::size_t i {0}; i < packet.inputCount; ++i) {
+        session.add_remote_input(packet.firstInputTick + i, packet.inputs[i]);
+      }
+      if (packet.hasChecksum) {
+        session.add_remote_checksum(packet.checksumTick, packet.checksum);
+      }
+    }
+
+    // Both peers see each other as behind by the latency, so a peer only
+    // waits for the other one when it's further ahead than the other one
+    // thinks it is behind. Otherwise the peer that started first would keep
+    // predicting the furthest and do most of the rolling back.
+    auto const advantage = static_cast<s32>(session.match().tick()) -
+                           static_cast<s32>(remoteTick);
+    if (session.match().tick() < config.ticks) {
+      auto const ahead = advantage - remoteAdvantage >= 2;
+      if (session.can_advance() and not ahead) {
+        session.advance(bot.next_input());
+      } else {
+        ++stalls;
+      }
+    } else {
+      session.resimulate();
+      if (not doneTime and session.confirmed_tick() == config.ticks and
+          remoteAck >= session.local_input_end()) {
+        doneTime = now;
+      }
+    }
+
+    Packet packet {};
+    packet.ack = session.remote_input_end();
+    packet.tick = session.match().tick();
+    packet.advantage = advantage;
+    packet.firstInputTick =
+        std::max(remoteAck, session.local_input_end() -
+                                std::min(session.local_input_end(),
+                                         u64 {maxInputsPerPacket}));
+    packet.inputCount = static_cast<u8>(session.local_input_end() -
+                                        packet.firstInputTick);
+    for (std::size_t i {0}; i < packet.inputCount; ++i) {
+      packet.inputs[i] = *session.local_input(packet.firstInputTick + i);
+    }
+    if (auto const checksum = session.latest_checksum()) {
+      packet.hasChecksum = true;
+      packet.checksumTick = checksum->first;
+      packet.checksum = checksum->second;
+    }
+    Snapshot::Writer writer;
+    writer(packet);
+    sender.send(writer.take_bytes(), now);
+
+    if (doneTime and now - *doneTime > lingerTime) {
+      break;
+    }
+    nextFrame += frameTime;
+    std::this_thread::sleep_until(nextFrame);
+  }
+
+  auto const& stats = session.stats();
+  fmt::print("Rollbacks: {}, resimulated ticks: {}, deepest rollback: {} "
+             "ticks, slowest rollback: {:.3f}ms, stalled frames: {}\n",
+             stats.rollbacks, stats.resimulatedTicks, stats.maxRollbackDepth,
+             std::chrono::duration<double, std::milli> {stats.maxRollbackTime}
+                 .count(),
+             stalls);
+  fmt::print("Checksum at tick {}: {:016x}\n", session.match().tick(),
+             Snapshot::checksum(session.match()));
+  if (auto const desyncTick = session.desync_tick()) {
+    fmt::print("Desynced at tick {}!\n", *desyncTick);
+    return false;
+  }
+  return true;
+}
+
+} // namespace Rollback
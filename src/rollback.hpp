@@ -0,0 +1,159 @@
+#pragma once
+
+#include "game.hpp"
+#include "versus.hpp"
+
+#include "jint.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+// GGPO style rollback for two player versus. Remote inputs are predicted so
+// the game never waits for the network, and when an input arrives that
+// doesn't match its prediction the match is restored to the tick it belongs
+// to and re-simulated up to the present.
+namespace Rollback {
+
+using Match = Versus::Match<2>;
+
+// Snapshots are plain copies of the match.
+static_assert(std::is_trivially_copyable_v<Match>);
+
+// How many ticks the session can run ahead of the last confirmed remote
+// input. Re-simulating this many ticks has to fit within a single frame.
+u64 constexpr maxPrediction {8};
+u64 constexpr maxInputDelay {8};
+// Peers exchange a checksum of their confirmed state every this many ticks.
+u64 constexpr checksumInterval {30};
+
+struct Stats {
+  u64 rollbacks {0};
+  u64 resimulatedTicks {0};
+  u64 maxRollbackDepth {0};
+  std::chrono::nanoseconds maxRollbackTime {0};
+};
+
+// The network independent half of a rollback session: it's fed the local and
+// remote inputs and keeps the match up to date with them.
+class Session {
+public:
+  // Inputs are kept for longer than they can be rolled back, since they have
+  // to be resent until the remote peer acknowledges them.
+  u64 static constexpr inputCapacity {64};
+
+  // The local input is delayed by `inputDelay` ticks, which gives it that
+  // much time to reach the remote peer before it needs it, so there are fewer
+  // rollbacks at the cost of some responsiveness.
+  Session(Match const& match, std::size_t localPlayer, u64 inputDelay);
+
+  // Whether the session can advance another tick without predicting too far
+  // past the last confirmed remote input.
+  [[nodiscard]] auto can_advance() const -> bool;
+
+  // Records the local input for the tick `inputDelay` ticks from now and
+  // steps the match one tick, rolling back first if a prediction turned out
+  // wrong. Must only be called if can_advance().
+  auto advance(Input localInput) -> void;
+
+  // Applies a pending rollback without advancing, e.g. while waiting for the
+  // remote peer at the end of a match.
+  auto resimulate() -> void;
+
+  // Remote inputs can arrive in any order and more than once.
+  auto add_remote_input(u64 tick, Input input) -> void;
+  // Compares the remote peer's checksum with ours for the same tick, if
+  // ours is still known.
+  auto add_remote_checksum(u64 tick, u64 checksum) -> void;
+
+  [[nodiscard]] auto local_input(u64 tick) const -> std::optional<Input>;
+  // The last tick the local input is known for, plus one.
+  [[nodiscard]] auto local_input_end() const -> u64 {
+    return m_match.tick() + m_inputDelay;
+  }
+  // Every remote input before this tick has been received.
+  [[nodiscard]] auto remote_input_end() const -> u64 {
+    return m_remoteConfirmed;
+  }
+  // Every tick before this one has both players' inputs confirmed.
+  [[nodiscard]] auto confirmed_tick() const -> u64 {
+    return std::min(m_remoteConfirmed, m_match.tick());
+  }
+  // The newest checksum of a confirmed tick, if any.
+  [[nodiscard]] auto latest_checksum() const
+      -> std::optional<std::pair<u64, u64>>;
+  // The first tick a checksum mismatch was found for, if any.
+  [[nodiscard]] auto desync_tick() const -> std::optional<u64> {
+    return m_desyncTick;
+  }
+
+  [[nodiscard]] auto match() const -> Match const& { return m_match; }
+  [[nodiscard]] auto local_player() const -> std::size_t {
+    return m_localPlayer;
+  }
+  [[nodiscard]] auto stats() const -> Stats const& { return m_stats; }
+
+private:
+  struct TaggedInput {
+    u64 tick {~u64 {0}};
+    Input input {};
+  };
+
+  struct Checksum {
+    u64 tick {~u64 {0}};
+    u64 value {0};
+  };
+
+  u64 static constexpr stateCapacity {maxPrediction * 2};
+  std::size_t static constexpr checksumCapacity {8};
+
+  [[nodiscard]] auto predicted_remote_input(u64 tick) const -> Input;
+  [[nodiscard]] auto inputs_for(u64 tick) -> Match::Inputs;
+  auto step() -> void;
+  auto record_checksums() -> void;
+  auto compare_checksums(u64 tick) -> void;
+
+  Match m_match;
+  std::size_t m_localPlayer;
+  u64 m_inputDelay;
+
+  // The match as it was at the start of each of the last ticks.
+  std::array<Match, stateCapacity> m_states;
+  std::array<TaggedInput, inputCapacity> m_localInputs {};
+  std::array<TaggedInput, inputCapacity> m_remoteInputs {};
+  // The remote inputs that were used for the ticks that have been simulated,
+  // whether they were predicted or not.
+  std::array<TaggedInput, inputCapacity> m_usedRemoteInputs {};
+  u64 m_remoteConfirmed {0};
+  std::optional<u64> m_rollbackTick {};
+
+  std::array<Checksum, checksumCapacity> m_localChecksums {};
+  std::array<Checksum, checksumCapacity> m_remoteChecksums {};
+  u64 m_nextChecksumTick {0};
+  std::optional<u64> m_desyncTick {};
+
+  Stats m_stats {};
+};
+
+struct NetplayConfig {
+  u16 localPort {7000};
+  u16 remotePort {7001};
+  u64 inputDelay {2};
+  // Added to every packet sent, to test the rollback without a real network.
+  std::chrono::milliseconds latency {0};
+  // How many ticks to play before both peers compare their final state.
+  u64 ticks {60 * 60};
+};
+
+// Plays a match against another process on the loopback interface, with
+// bots pressing the buttons for both players. Each peer drives its own
+// player and predicts the other one, and at the end both print the checksum of
+// the same confirmed tick, which has to match. Returns false on a desync or
+// if the socket couldn't be opened.
+auto run_netplay(NetplayConfig const& config) -> bool;
+
+} // namespace Rollback
@@ -1,51 +1,18 @@
 #include "shape.hpp"
 
 #include "board.hpp"
-#include "rangealgorithms.hpp"
 #include "util.hpp"
 
-#include <cassert>
-#include <random>
 #include <stdexcept>
 #include <string>
 
 using namespace std::string_literals;
 
-Shape::Shape(Type const type) noexcept
-    : m_type {type}, color {to_color(type)}, pos {Board::columns / 2 - 2, 0} {}
+template <typename System>
+BasicShape<System>::BasicShape(Type const type) noexcept
+    : color {to_color(type)},
+      pos {System::spawn_position(type, Board::columns)}, m_type {type} {}
 
-ShapePool::ShapePool(ShapePool::DataType const& shapes)
-    : shapePool {shapes}, previewPool {shapes} {
-  reshuffle();
-}
-
-auto ShapePool::reshuffle() -> void {
-  // TODO: seed random engine
-  shuffle(shapePool, std::default_random_engine());
-  shuffle(previewPool, std::default_random_engine());
-}
-
-auto ShapePool::next_shape() -> Shape {
-  ++currentShapeIndex;
-  if (currentShapeIndex == shapePool.size()) {
-    shapePool = previewPool;
-    currentShapeIndex = 0;
-    shuffle(previewPool, std::default_random_engine());
-  }
-  return Shape {shapePool[currentShapeIndex]};
-}
-
-auto ShapePool::current_shape() const -> Shape {
-  return Shape {shapePool[currentShapeIndex]};
-}
-
-auto ShapePool::get_preview_shapes_array() const -> PreviewStack {
-  PreviewStack lookaheadArray;
-  for (auto i = currentShapeIndex + 1; i != shapePool.size(); ++i) {
-    lookaheadArray.push_back(shapePool[i]);
-  }
-  for (auto const shape : previewPool) {
-    lookaheadArray.push_back(shape);
-  }
-  return lookaheadArray;
-}
+template class BasicShape<RotationSystem::SRS>;
+template class BasicShape<RotationSystem::ARS>;
+template class BasicShape<RotationSystem::NoKicks>;
@@ -6,87 +6,37 @@
 
 #include "fmt/core.h"
 
+#include <gsl/gsl>
+
 #include <exception>
 #include <stdexcept>
 
-class Shape {
+// The parts of a shape that don't depend on the rotation system being used.
+class ShapeBase {
 public:
-  enum class RotationType {
+  enum class RotationType : u8 {
     Wallkick,
     Regular,
   };
 
-  enum class Type { I, O, L, J, S, Z, T };
+  enum class Type : u8 { I, O, L, J, S, Z, T };
+  std::size_t static constexpr typeCount {7};
 
   // The shape with the maximum height is the I shape (4 blocks tall).
   u8 static constexpr maxHeight {4};
 
-  enum class RotationDirection { Left, Right };
-
-  enum class Rotation { r0, r90, r180, r270 };
+  enum class RotationDirection : u8 { Left, Right };
 
-  Color::RGBA color {Color::invalid};
-  Point<int> pos;
+  enum class Rotation : u8 { r0, r90, r180, r270 };
 
   // All shapes are composed of 4 blocks.
   std::size_t static constexpr blockCount {4};
   using BlockStack = ArrayStack<Point<int>, blockCount>;
 
-  explicit Shape(Type type) noexcept;
-
-  // Returns the positions of the blocks relative to the top left corner of the
-  // play area
-  [[nodiscard]] auto constexpr get_absolute_block_positions() const
-      -> BlockStack {
-    auto positions = get_local_block_positions();
-    for (auto& localPosition : positions) {
-      localPosition.x += pos.x;
-      localPosition.y += pos.y;
-    }
-    return positions;
-  }
-
-  [[nodiscard]] auto constexpr get_wallkicks(
-      Shape::RotationDirection const dir) const -> std::array<V2, 4> {
-    auto const i = static_cast<gsl::index>(m_rotation);
-    auto const j = static_cast<gsl::index>(dir);
-
-    using gsl::at;
-
-    switch (m_type) {
-    case Shape::Type::J:
-    case Shape::Type::L:
-    case Shape::Type::S:
-    case Shape::Type::T:
-    case Shape::Type::Z: {
-      return at(at(WallKicks::JLSTZ, i), j);
-    }
-    case Shape::Type::I: {
-      return at(at(WallKicks::I, i), j);
-    }
-    case Shape::Type::O:
-      return {};
-    }
-    // Unreachable.
-    std::terminate();
-  }
-
-  [[nodiscard]] auto constexpr dimensions() const -> Rect<int>::Size {
-    switch (m_type) {
-    case Type::I:
-      return {4, 1};
-    case Type::O:
-      return {2, 2};
-    case Type::L:
-    case Type::J:
-    case Type::S:
-    case Type::Z:
-    case Type::T:
-      return {3, 2};
-    }
-    // Unreachable.
-    std::terminate();
-  }
+  Rect<std::size_t>::Size static constexpr layoutDimensions {4, 4};
+  using Layout = std::array<bool, layoutDimensions.w * layoutDimensions.h>;
+  using RotationMap = std::array<Layout, 4>;
+  using RotationMaps = std::array<RotationMap, typeCount>;
 
   auto constexpr friend operator+=(Rotation& rotation,
                                    RotationDirection const& direction) noexcept
@@ -129,45 +79,6 @@ public:
     return rotation;
   }
 
-  [[nodiscard]] auto type() const noexcept -> Type { return m_type; }
-
-  auto rotate(RotationDirection const dir) -> Shape& {
-    m_rotation += dir;
-    return *this;
-  }
-
-  auto translate(V2 const dir) -> Shape& {
-    pos += dir;
-    return *this;
-  }
-
-private:
-  Rect<std::size_t>::Size static constexpr layoutDimensions {4, 4};
-  using Layout = std::array<bool, layoutDimensions.w * layoutDimensions.h>;
-  using RotationMap = std::array<Layout, 4>;
-
-  // Returns the positions of the blocks relative to the top left corner of its
-  // 4x4 rotation map
-  [[nodiscard]] auto constexpr get_local_block_positions() const -> BlockStack {
-    BlockStack positions {};
-    auto const& layout = get_layout();
-    for (std::size_t y {0}; y < layoutDimensions.h; ++y) {
-      for (std::size_t x {0}; x < layoutDimensions.w; ++x) {
-        auto const index =
-            gsl::narrow_cast<gsl::index>(y * layoutDimensions.w + x);
-        if (gsl::at(layout, index)) {
-          positions.push_back({static_cast<int>(x), static_cast<int>(y)});
-          if (positions.size() == positions.max_size()) {
-            return positions;
-          }
-        }
-      }
-    }
-    throw std::logic_error(fmt::format(
-        "Rotation map ({}) with rotation ({}) has fewer than 4 blocks active.",
-        m_type, m_rotation));
-  }
-
   [[nodiscard]] auto static constexpr to_color(Type const type) -> Color::RGBA {
     switch (type) {
     case Type::I:
@@ -188,29 +99,57 @@ private:
     // Unreachable.
     std::terminate();
   }
+};
 
-  [[nodiscard]] auto constexpr get_layout() const -> Layout const& {
-    auto const index = static_cast<RotationMap::size_type>(m_rotation);
-    switch (m_type) {
-    case Shape::Type::I:
-      return RotationMaps::I[index];
-    case Shape::Type::O:
-      return RotationMaps::O[index];
-    case Shape::Type::L:
-      return RotationMaps::L[index];
-    case Shape::Type::J:
-      return RotationMaps::J[index];
-    case Shape::Type::S:
-      return RotationMaps::S[index];
-    case Shape::Type::Z:
-      return RotationMaps::Z[index];
-    case Shape::Type::T:
-      return RotationMaps::T[index];
+// A rotation system decides the layout of every shape in each of its
+// rotations, where shapes spawn, and which kicks are tried when a rotation is
+// blocked. They are used as compile time policies for BasicShape, so each
+// one provides the same set of static constexpr functions:
+//
+//   layout(Type, Rotation) -> Layout const&
+//   wallkicks(Type, Rotation, RotationDirection) -> gsl::span<V2 const>
+//   spawn_position(Type, int boardColumns) -> Point<int>
+//
+// The y in kicks is bottom up, while it's top down for shape positions.
+namespace RotationSystem {
+
+// The Super Rotation System used by most modern games.
+// https://harddrop.com/wiki/SRS
+struct SRS {
+  [[nodiscard]] auto static constexpr layout(ShapeBase::Type const type,
+                                             ShapeBase::Rotation const rotation)
+      -> ShapeBase::Layout const& {
+    return rotationMaps[static_cast<std::size_t>(type)]
+                       [static_cast<std::size_t>(rotation)];
+  }
+
+  [[nodiscard]] auto static constexpr wallkicks(
+      ShapeBase::Type const type, ShapeBase::Rotation const rotation,
+      ShapeBase::RotationDirection const dir) -> gsl::span<V2 const> {
+    auto const i = static_cast<std::size_t>(rotation);
+    auto const j = static_cast<std::size_t>(dir);
+
+    switch (type) {
+    case ShapeBase::Type::J:
+    case ShapeBase::Type::L:
+    case ShapeBase::Type::S:
+    case ShapeBase::Type::T:
+    case ShapeBase::Type::Z:
+      return WallKicks::JLSTZ[i][j];
+    case ShapeBase::Type::I:
+      return WallKicks::I[i][j];
+    case ShapeBase::Type::O:
+      return {};
     }
     // Unreachable.
     std::terminate();
   }
 
+  [[nodiscard]] auto static constexpr spawn_position(
+      ShapeBase::Type const /*type*/, int const boardColumns) -> Point<int> {
+    return {boardColumns / 2 - 2, 0};
+  }
+
   struct WallKicks {
     // Shapes J, L, S, T, and Z all have the same wall kicks while I has its
     // own and O can't kick since it doesn't rotate at all.
@@ -261,213 +200,562 @@ private:
     };
   };
 
-  struct RotationMaps {
-    auto static constexpr o = false;
-    auto static constexpr X = true;
+  auto static constexpr o = false;
+  auto static constexpr X = true;
+
+  // Indexed by ShapeBase::Type.
+  ShapeBase::RotationMaps static constexpr rotationMaps {
+      // I
+      ShapeBase::RotationMap {
+          ShapeBase::Layout {
+              o, o, o, o, //
+              X, X, X, X, //
+              o, o, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, o, X, o, //
+              o, o, X, o, //
+              o, o, X, o, //
+              o, o, X, o, //
+          },
+          ShapeBase::Layout {
+              o, o, o, o, //
+              o, o, o, o, //
+              X, X, X, X, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, X, o, o, //
+              o, X, o, o, //
+              o, X, o, o, //
+              o, X, o, o, //
+          },
+      },
+      // O
+      ShapeBase::RotationMap {
+          ShapeBase::Layout {
+              o, X, X, o, //
+              o, X, X, o, //
+              o, o, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, X, X, o, //
+              o, X, X, o, //
+              o, o, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, X, X, o, //
+              o, X, X, o, //
+              o, o, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, X, X, o, //
+              o, X, X, o, //
+              o, o, o, o, //
+              o, o, o, o, //
+          },
+      },
+      // L
+      ShapeBase::RotationMap {
+          ShapeBase::Layout {
+              o, o, X, o, //
+              X, X, X, o, //
+              o, o, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, X, o, o, //
+              o, X, o, o, //
+              o, X, X, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, o, o, o, //
+              X, X, X, o, //
+              X, o, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              X, X, o, o, //
+              o, X, o, o, //
+              o, X, o, o, //
+              o, o, o, o, //
+          },
+      },
+      // J
+      ShapeBase::RotationMap {
+          ShapeBase::Layout {
+              X, o, o, o, //
+              X, X, X, o, //
+              o, o, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, X, X, o, //
+              o, X, o, o, //
+              o, X, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, o, o, o, //
+              X, X, X, o, //
+              o, o, X, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, X, o, o, //
+              o, X, o, o, //
+              X, X, o, o, //
+              o, o, o, o, //
+          },
+      },
+      // S
+      ShapeBase::RotationMap {
+          ShapeBase::Layout {
+              o, X, X, o, //
+              X, X, o, o, //
+              o, o, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, X, o, o, //
+              o, X, X, o, //
+              o, o, X, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, o, o, o, //
+              o, X, X, o, //
+              X, X, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              X, o, o, o, //
+              X, X, o, o, //
+              o, X, o, o, //
+              o, o, o, o, //
+          },
+      },
+      // Z
+      ShapeBase::RotationMap {
+          ShapeBase::Layout {
+              X, X, o, o, //
+              o, X, X, o, //
+              o, o, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, o, X, o, //
+              o, X, X, o, //
+              o, X, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, o, o, o, //
+              X, X, o, o, //
+              o, X, X, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, X, o, o, //
+              X, X, o, o, //
+              X, o, o, o, //
+              o, o, o, o, //
+          },
+      },
+      // T
+      ShapeBase::RotationMap {
+          ShapeBase::Layout {
+              o, X, o, o, //
+              X, X, X, o, //
+              o, o, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, X, o, o, //
+              o, X, X, o, //
+              o, X, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, o, o, o, //
+              X, X, X, o, //
+              o, X, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, X, o, o, //
+              X, X, o, o, //
+              o, X, o, o, //
+              o, o, o, o, //
+          },
+      },
+  };
+};
 
-    RotationMap static constexpr I {
-        Layout {
-            o, o, o, o, //
-            X, X, X, X, //
-            o, o, o, o, //
-            o, o, o, o, //
-        },
-        Layout {
-            o, o, X, o, //
-            o, o, X, o, //
-            o, o, X, o, //
-            o, o, X, o, //
-        },
-        Layout {
-            o, o, o, o, //
-            o, o, o, o, //
-            X, X, X, X, //
-            o, o, o, o, //
-        },
-        Layout {
-            o, X, o, o, //
-            o, X, o, o, //
-            o, X, o, o, //
-            o, X, o, o, //
-        },
-    };
-    RotationMap static constexpr L {
-        Layout {
-            o, o, X, o, //
-            X, X, X, o, //
-            o, o, o, o, //
-            o, o, o, o, //
-        },
-        Layout {
-            o, X, o, o, //
-            o, X, o, o, //
-            o, X, X, o, //
-            o, o, o, o, //
-        },
-        Layout {
-            o, o, o, o, //
-            X, X, X, o, //
-            X, o, o, o, //
-            o, o, o, o, //
-        },
-        Layout {
-            X, X, o, o, //
-            o, X, o, o, //
-            o, X, o, o, //
-            o, o, o, o, //
-        },
-    };
-    RotationMap static constexpr J {
-        Layout {
-            X, o, o, o, //
-            X, X, X, o, //
-            o, o, o, o, //
-            o, o, o, o, //
-        },
-        Layout {
-            o, X, X, o, //
-            o, X, o, o, //
-            o, X, o, o, //
-            o, o, o, o, //
-        },
-        Layout {
-            o, o, o, o, //
-            X, X, X, o, //
-            o, o, X, o, //
-            o, o, o, o, //
-        },
-        Layout {
-            o, X, o, o, //
-            o, X, o, o, //
-            X, X, o, o, //
-            o, o, o, o, //
-        },
-    };
-    RotationMap static constexpr O {
-        Layout {
-            o, X, X, o, //
-            o, X, X, o, //
-            o, o, o, o, //
-            o, o, o, o, //
-        },
-        Layout {
-            o, X, X, o, //
-            o, X, X, o, //
-            o, o, o, o, //
-            o, o, o, o, //
-        },
-        Layout {
-            o, X, X, o, //
-            o, X, X, o, //
-            o, o, o, o, //
-            o, o, o, o, //
-        },
-        Layout {
-            o, X, X, o, //
-            o, X, X, o, //
-            o, o, o, o, //
-            o, o, o, o, //
-        },
-    };
-    RotationMap static constexpr S {
-        Layout {
-            o, X, X, o, //
-            X, X, o, o, //
-            o, o, o, o, //
-            o, o, o, o, //
-        },
-        Layout {
-            o, X, o, o, //
-            o, X, X, o, //
-            o, o, X, o, //
-            o, o, o, o, //
-        },
-        Layout {
-            o, o, o, o, //
-            o, X, X, o, //
-            X, X, o, o, //
-            o, o, o, o, //
-        },
-        Layout {
-            X, o, o, o, //
-            X, X, o, o, //
-            o, X, o, o, //
-            o, o, o, o, //
-        },
-    };
-    RotationMap static constexpr Z {
-        Layout {
-            X, X, o, o, //
-            o, X, X, o, //
-            o, o, o, o, //
-            o, o, o, o, //
-        },
-        Layout {
-            o, o, X, o, //
-            o, X, X, o, //
-            o, X, o, o, //
-            o, o, o, o, //
-        },
-        Layout {
-            o, o, o, o, //
-            X, X, o, o, //
-            o, X, X, X, //
-            o, o, o, o, //
-        },
-        Layout {
-            o, X, o, o, //
-            X, X, o, o, //
-            X, o, o, o, //
-            o, o, o, o, //
-        },
-    };
-    RotationMap static constexpr T {
-        Layout {
-            o, X, o, o, //
-            X, X, X, o, //
-            o, o, o, o, //
-            o, o, o, o, //
-        },
-        Layout {
-            o, X, o, o, //
-            o, X, X, o, //
-            o, X, o, o, //
-            o, o, o, o, //
-        },
-        Layout {
-            o, o, o, o, //
-            X, X, X, o, //
-            o, X, o, o, //
-            o, o, o, o, //
-        },
-        Layout {
-            o, X, o, o, //
-            X, X, o, o, //
-            o, X, o, o, //
-            o, o, o, o, //
-        },
-    };
+// The Arika Rotation System used by the TGM series. Shapes are bottom aligned
+// in their 3x3 box and spawn flat side up. A blocked rotation is retried one
+// column to the right and then one column to the left, except for I which
+// never kicks.
+// https://tetris.wiki/Arika_Rotation_System
+//
+// The center column rule for J, L and T is not implemented.
+struct ARS {
+  [[nodiscard]] auto static constexpr layout(ShapeBase::Type const type,
+                                             ShapeBase::Rotation const rotation)
+      -> ShapeBase::Layout const& {
+    return rotationMaps[static_cast<std::size_t>(type)]
+                       [static_cast<std::size_t>(rotation)];
+  }
+
+  [[nodiscard]] auto static constexpr wallkicks(
+      ShapeBase::Type const type, ShapeBase::Rotation const /*rotation*/,
+      ShapeBase::RotationDirection const /*dir*/) -> gsl::span<V2 const> {
+    switch (type) {
+    case ShapeBase::Type::J:
+    case ShapeBase::Type::L:
+    case ShapeBase::Type::S:
+    case ShapeBase::Type::T:
+    case ShapeBase::Type::Z:
+      return kicks;
+    case ShapeBase::Type::I:
+    case ShapeBase::Type::O:
+      return {};
+    }
+    // Unreachable.
+    std::terminate();
+  }
+
+  // The layouts other than I's are one row lower in their box than in SRS, so
+  // those shapes spawn one row higher to end up in the same place on the
+  // board.
+  [[nodiscard]] auto static constexpr spawn_position(
+      ShapeBase::Type const type, int const boardColumns) -> Point<int> {
+    return {boardColumns / 2 - 2, type == ShapeBase::Type::I ? 0 : -1};
+  }
+
+  std::array static constexpr kicks {V2 {1, 0}, V2 {-1, 0}};
+
+  auto static constexpr o = false;
+  auto static constexpr X = true;
+
+  // Indexed by ShapeBase::Type.
+  ShapeBase::RotationMaps static constexpr rotationMaps {
+      // I
+      ShapeBase::RotationMap {
+          ShapeBase::Layout {
+              o, o, o, o, //
+              X, X, X, X, //
+              o, o, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, o, X, o, //
+              o, o, X, o, //
+              o, o, X, o, //
+              o, o, X, o, //
+          },
+          ShapeBase::Layout {
+              o, o, o, o, //
+              X, X, X, X, //
+              o, o, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, o, X, o, //
+              o, o, X, o, //
+              o, o, X, o, //
+              o, o, X, o, //
+          },
+      },
+      // O
+      ShapeBase::RotationMap {
+          ShapeBase::Layout {
+              o, o, o, o, //
+              o, X, X, o, //
+              o, X, X, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, o, o, o, //
+              o, X, X, o, //
+              o, X, X, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, o, o, o, //
+              o, X, X, o, //
+              o, X, X, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, o, o, o, //
+              o, X, X, o, //
+              o, X, X, o, //
+              o, o, o, o, //
+          },
+      },
+      // L
+      ShapeBase::RotationMap {
+          ShapeBase::Layout {
+              o, o, o, o, //
+              X, X, X, o, //
+              X, o, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              X, X, o, o, //
+              o, X, o, o, //
+              o, X, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, o, o, o, //
+              o, o, X, o, //
+              X, X, X, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, X, o, o, //
+              o, X, o, o, //
+              o, X, X, o, //
+              o, o, o, o, //
+          },
+      },
+      // J
+      ShapeBase::RotationMap {
+          ShapeBase::Layout {
+              o, o, o, o, //
+              X, X, X, o, //
+              o, o, X, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, X, o, o, //
+              o, X, o, o, //
+              X, X, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, o, o, o, //
+              X, o, o, o, //
+              X, X, X, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, X, X, o, //
+              o, X, o, o, //
+              o, X, o, o, //
+              o, o, o, o, //
+          },
+      },
+      // S
+      ShapeBase::RotationMap {
+          ShapeBase::Layout {
+              o, o, o, o, //
+              o, X, X, o, //
+              X, X, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              X, o, o, o, //
+              X, X, o, o, //
+              o, X, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, o, o, o, //
+              o, X, X, o, //
+              X, X, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              X, o, o, o, //
+              X, X, o, o, //
+              o, X, o, o, //
+              o, o, o, o, //
+          },
+      },
+      // Z
+      ShapeBase::RotationMap {
+          ShapeBase::Layout {
+              o, o, o, o, //
+              X, X, o, o, //
+              o, X, X, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, o, X, o, //
+              o, X, X, o, //
+              o, X, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, o, o, o, //
+              X, X, o, o, //
+              o, X, X, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, o, X, o, //
+              o, X, X, o, //
+              o, X, o, o, //
+              o, o, o, o, //
+          },
+      },
+      // T
+      ShapeBase::RotationMap {
+          ShapeBase::Layout {
+              o, o, o, o, //
+              X, X, X, o, //
+              o, X, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, X, o, o, //
+              X, X, o, o, //
+              o, X, o, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, o, o, o, //
+              o, X, o, o, //
+              X, X, X, o, //
+              o, o, o, o, //
+          },
+          ShapeBase::Layout {
+              o, X, o, o, //
+              o, X, X, o, //
+              o, X, o, o, //
+              o, o, o, o, //
+          },
+      },
   };
+};
 
-  Type m_type;
-  Rotation m_rotation {Rotation::r0};
+// SRS layouts and spawn positions, but a blocked rotation simply fails.
+struct NoKicks {
+  [[nodiscard]] auto static constexpr layout(ShapeBase::Type const type,
+                                             ShapeBase::Rotation const rotation)
+      -> ShapeBase::Layout const& {
+    return SRS::layout(type, rotation);
+  }
+
+  [[nodiscard]] auto static constexpr wallkicks(
+      ShapeBase::Type const /*type*/, ShapeBase::Rotation const /*rotation*/,
+      ShapeBase::RotationDirection const /*dir*/) -> gsl::span<V2 const> {
+    return {};
+  }
+
+  [[nodiscard]] auto static constexpr spawn_position(
+      ShapeBase::Type const type, int const boardColumns) -> Point<int> {
+    return SRS::spawn_position(type, boardColumns);
+  }
 };
 
-class ShapePool {
+} // namespace RotationSystem
+
+template <typename System>
+class BasicShape : public ShapeBase {
 public:
-  std::size_t static constexpr size {7};
-  using DataType = std::array<Shape::Type, size>;
-  using PreviewStack = ArrayStack<Shape::Type, size * 2>;
+  using RotationSystem = System;
+
+  Color::RGBA color {Color::invalid};
+  Point<int> pos;
 
-  explicit ShapePool(DataType const& shapes);
+  explicit BasicShape(Type type) noexcept;
 
-  auto reshuffle() -> void;
-  auto next_shape() -> Shape;
-  [[nodiscard]] auto current_shape() const -> Shape;
-  [[nodiscard]] auto get_preview_shapes_array() const -> PreviewStack;
+  // Returns the positions of the blocks relative to the top left corner of the
+  // play area
+  [[nodiscard]] auto constexpr get_absolute_block_positions() const
+      -> BlockStack {
+    auto positions = get_local_block_positions();
+    for (auto& localPosition : positions) {
+      localPosition.x += pos.x;
+      localPosition.y += pos.y;
+    }
+    return positions;
+  }
+
+  [[nodiscard]] auto constexpr get_wallkicks(
+      RotationDirection const dir) const -> gsl::span<V2 const> {
+    return System::wallkicks(m_type, m_rotation, dir);
+  }
+
+  [[nodiscard]] auto constexpr dimensions() const -> Rect<int>::Size {
+    switch (m_type) {
+    case Type::I:
+      return {4, 1};
+    case Type::O:
+      return {2, 2};
+    case Type::L:
+    case Type::J:
+    case Type::S:
+    case Type::Z:
+    case Type::T:
+      return {3, 2};
+    }
+    // Unreachable.
+    std::terminate();
+  }
+
+  [[nodiscard]] auto type() const noexcept -> Type { return m_type; }
+  [[nodiscard]] auto rotation() const noexcept -> Rotation {
+    return m_rotation;
+  }
+
+  auto rotate(RotationDirection const dir) -> BasicShape& {
+    m_rotation += dir;
+    return *this;
+  }
+
+  auto translate(V2 const dir) -> BasicShape& {
+    pos += dir;
+    return *this;
+  }
+
+  // Visits every field, see snapshot.hpp.
+  template <typename Archive>
+  auto serialize(Archive& archive) -> void {
+    archive(color, pos, m_type, m_rotation);
+  }
 
 private:
-  DataType shapePool {};
-  DataType previewPool {};
-  DataType::size_type currentShapeIndex {0};
+  // Returns the positions of the blocks relative to the top left corner of its
+  // 4x4 rotation map
+  [[nodiscard]] auto constexpr get_local_block_positions() const -> BlockStack {
+    BlockStack positions {};
+    auto const& layout = System::layout(m_type, m_rotation);
+    for (std::size_t y {0}; y < layoutDimensions.h; ++y) {
+      for (std::size_t x {0}; x < layoutDimensions.w; ++x) {
+        auto const index =
+            gsl::narrow_cast<gsl::index>(y * layoutDimensions.w + x);
+        if (gsl::at(layout, index)) {
+          positions.push_back({static_cast<int>(x), static_cast<int>(y)});
+          if (positions.size() == positions.max_size()) {
+            return positions;
+          }
+        }
+      }
+    }
+    throw std::logic_error(fmt::format(
+        "Rotation map ({}) with rotation ({}) has fewer than 4 blocks active.",
+        m_type, m_rotation));
+  }
+
+  Type m_type;
+  Rotation m_rotation {Rotation::r0};
 };
+
+// The rotation system used by the game.
+using Shape = BasicShape<RotationSystem::SRS>;
+
+// The constructor needs the board's dimensions, so the supported rotation
+// systems are instantiated in shape.cpp.
+extern template class BasicShape<RotationSystem::SRS>;
+extern template class BasicShape<RotationSystem::ARS>;
+extern template class BasicShape<RotationSystem::NoKicks>;
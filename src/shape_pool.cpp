@@ -0,0 +1,60 @@
+#include "shape_pool.hpp"
+
+#include "rangealgorithms.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace Randomizer {
+
+auto History::next(Engine& engine) -> Shape::Type {
+  auto type = allTypes[random_index(engine, allTypes.size())];
+  if (m_first) {
+    m_first = false;
+    std::array static constexpr firstTypes {Shape::Type::I, Shape::Type::J,
+                                            Shape::Type::L, Shape::Type::T};
+    type = firstTypes[random_index(engine, firstTypes.size())];
+  } else {
+    for (std::size_t roll {1}; roll < rolls; ++roll) {
+      auto const inHistory =
+          any_of(m_history, [type](auto const t) { return t == type; });
+      if (not inHistory) {
+        break;
+      }
+      type = allTypes[random_index(engine, allTypes.size())];
+    }
+  }
+
+  std::rotate(m_history.begin(), m_history.begin() + 1, m_history.end());
+  m_history.back() = type;
+  return type;
+}
+
+auto Random::next(Engine& engine) -> Shape::Type {
+  return allTypes[random_index(engine, allTypes.size())];
+}
+
+} // namespace Randomizer
+
+ShapePool::ShapePool(Randomizer::Any randomizer,
+                     Randomizer::Engine::result_type const seed)
+    : m_engine {seed}, m_randomizer {std::move(randomizer)} {
+  generate();
+}
+
+auto ShapePool::generate() -> void {
+  assert(m_size < capacity);
+  auto const type = std::visit(
+      [this](auto& randomizer) { return randomizer.next(m_engine); },
+      m_randomizer);
+  m_queue[(m_head + m_size) & (capacity - 1)] = type;
+  ++m_size;
+}
+
+auto ShapePool::next_shape() -> Shape {
+  m_head = gsl::narrow_cast<u8>((m_head + 1U) & (capacity - 1));
+  --m_size;
+  return Shape {peek(0)};
+}
+
+auto ShapePool::current_shape() const -> Shape { return Shape {peek(0)}; }
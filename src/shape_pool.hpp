@@ -0,0 +1,194 @@
+#pragma once
+
+#include "shape.hpp"
+#include "util.hpp"
+
+#include "jint.h"
+
+#include <array>
+#include <cassert>
+#include <exception>
+#include <variant>
+
+// Randomizers decide the order in which shapes are dealt. They are plain
+// values (including their random engine's state lives in the ShapePool), so a
+// GameState holding one can still be copied around freely.
+namespace Randomizer {
+
+// SplitMix64. Its whole state is a single integer, so unlike the standard
+// engines it can be saved and restored along with the rest of a game.
+class Engine {
+public:
+  using result_type = u64;
+  result_type static constexpr default_seed {0x5EED'5EED'5EED'5EEDULL};
+
+  constexpr explicit Engine(result_type const seed = default_seed) noexcept
+      : m_state {seed} {}
+
+  [[nodiscard]] auto static constexpr min() noexcept -> result_type {
+    return 0;
+  }
+  [[nodiscard]] auto static constexpr max() noexcept -> result_type {
+    return ~result_type {0};
+  }
+
+  auto constexpr operator()() noexcept -> result_type {
+    auto z = (m_state += 0x9E37'79B9'7F4A'7C15ULL);
+    z = (z ^ (z >> 30U)) * 0xBF58'476D'1CE4'E5B9ULL;
+    z = (z ^ (z >> 27U)) * 0x94D0'49BB'1331'11EBULL;
+    return z ^ (z >> 31U);
+  }
+
+  template <typename Archive>
+  auto serialize(Archive& archive) -> void {
+    archive(m_state);
+  }
+
+private:
+  result_type m_state;
+};
+
+std::array static constexpr allTypes {
+    Shape::Type::I, Shape::Type::O, Shape::Type::L, Shape::Type::J,
+    Shape::Type::S, Shape::Type::Z, Shape::Type::T,
+};
+static_assert(allTypes.size() == Shape::typeCount);
+
+// Standard library distributions aren't guaranteed to produce the same
+// sequence on every implementation, which would break replays and netplay
+// between builds, so the engine's output is mapped to an index directly. The
+// modulo bias is negligible since the range is tiny compared to the engine's.
+[[nodiscard]] auto inline random_index(Engine& engine, std::size_t const count)
+    -> std::size_t {
+  return static_cast<std::size_t>(engine() - Engine::min()) % count;
+}
+
+// Deals every shape `copies` times in a random order before reshuffling.
+template <std::size_t copies>
+class Bag {
+public:
+  auto next(Engine& engine) -> Shape::Type {
+    if (m_index == m_bag.size()) {
+      refill(engine);
+    }
+    return m_bag[m_index++];
+  }
+
+  template <typename Archive>
+  auto serialize(Archive& archive) -> void {
+    archive(m_bag, m_index);
+    archive.check(m_index <= m_bag.size());
+  }
+
+private:
+  auto refill(Engine& engine) -> void {
+    for (std::size_t i {0}; i < m_bag.size(); ++i) {
+      m_bag[i] = allTypes[i % allTypes.size()];
+    }
+    // Fisher-Yates
+    for (auto i = m_bag.size() - 1; i > 0; --i) {
+      std::swap(m_bag[i], m_bag[random_index(engine, i + 1)]);
+    }
+    m_index = 0;
+  }
+
+  std::array<Shape::Type, Shape::typeCount * copies> m_bag {};
+  u8 m_index {static_cast<u8>(m_bag.size())};
+};
+
+using SevenBag = Bag<1>;
+using FourteenBag = Bag<2>;
+
+// The TGM2 randomizer. It remembers the last 4 shapes dealt and rerolls up to
+// 6 times while the new shape is one of them. The first shape is never an S, Z
+// or O.
+class History {
+public:
+  auto next(Engine& engine) -> Shape::Type;
+
+  template <typename Archive>
+  auto serialize(Archive& archive) -> void {
+    archive(m_history, m_first);
+  }
+
+private:
+  std::size_t static constexpr rolls {6};
+  std::array<Shape::Type, 4> m_history {Shape::Type::Z, Shape::Type::S,
+                                        Shape::Type::S, Shape::Type::Z};
+  bool m_first {true};
+};
+
+// Every shape is equally likely every time.
+class Random {
+public:
+  auto next(Engine& engine) -> Shape::Type;
+
+  template <typename Archive>
+  auto serialize(Archive& /*archive*/) -> void {}
+};
+
+using Any = std::variant<SevenBag, FourteenBag, History, Random>;
+
+} // namespace Randomizer
+
+// Generates shapes with a randomizer into a ring buffer queue. Shapes are
+// only generated when the queue is asked for them, so the preview can be as
+// deep as the queue's capacity without any extra cost for shallow previews.
+class ShapePool {
+public:
+  // Must be a power of two.
+  std::size_t static constexpr capacity {64};
+  Randomizer::Engine::result_type static constexpr defaultSeed {
+      Randomizer::Engine::default_seed};
+
+  explicit ShapePool(Randomizer::Any randomizer = Randomizer::SevenBag {},
+                     Randomizer::Engine::result_type seed = defaultSeed);
+
+  auto next_shape() -> Shape;
+  [[nodiscard]] auto current_shape() const -> Shape;
+
+  // Returns the shape `k` places after the current one, generating it first
+  // if necessary. peek(0) is the current shape.
+  [[nodiscard]] auto peek(std::size_t const k) -> Shape::Type {
+    assert(k < capacity);
+    while (m_size <= k) {
+      generate();
+    }
+    return m_queue[(m_head + k) & (capacity - 1)];
+  }
+
+  // Same as the non-const version, but the shape must already have been
+  // generated, see generate_ahead().
+  [[nodiscard]] auto peek(std::size_t const k) const -> Shape::Type {
+    // The rest of the ring only has stale shapes.
+    if (k >= m_size) {
+      std::terminate();
+    }
+    return m_queue[(m_head + k) & (capacity - 1)];
+  }
+
+  // Generates the `count` shapes after the current one, if they haven't been
+  // already, so that they can be peeked at in a const pool.
+  auto generate_ahead(std::size_t const count) -> void { (void)peek(count); }
+  // How many shapes have been generated, including the current one.
+  [[nodiscard]] auto generated() const noexcept -> std::size_t {
+    return m_size;
+  }
+
+  // Visits every field, see snapshot.hpp.
+  template <typename Archive>
+  auto serialize(Archive& archive) -> void {
+    archive(m_engine, m_randomizer, m_queue, m_head, m_size);
+    // There's always at least the current shape.
+    archive.check(m_head < capacity and m_size > 0 and m_size <= capacity);
+  }
+
+private:
+  auto generate() -> void;
+
+  Randomizer::Engine m_engine;
+  Randomizer::Any m_randomizer;
+  std::array<Shape::Type, capacity> m_queue {};
+  u8 m_head {0};
+  u8 m_size {0};
+};
@@ -0,0 +1,150 @@
+#include "snapshot.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Snapshot {
+
+auto fnv1a(gsl::span<u8 const> const bytes) -> u64 {
+  u64 hash {0xCBF2'9CE4'8422'2325ULL};
+  for (auto const byte : bytes) {
+    hash = (hash ^ byte) * 0x0000'0100'0000'01B3ULL;
+  }
+  return hash;
+}
+
+auto encode(GameState const& gameState) -> std::vector<u8> {
+  Writer payload;
+  payload(gameState);
+
+  Writer writer;
+  writer(magic, version, gsl::narrow_cast<u32>(payload.bytes().size()));
+  auto bytes = writer.take_bytes();
+  bytes.insert(bytes.end(), payload.bytes().begin(), payload.bytes().end());
+  assert(bytes.size() <= maxSize);
+  return bytes;
+}
+
+auto decode(gsl::span<u8 const> const bytes) -> std::optional<GameState> {
+  Reader reader {bytes};
+  std::array<u8, magic.size()> readMagic {};
+  u16 readVersion {};
+  u32 payloadSize {};
+  reader(readMagic, readVersion, payloadSize);
+  if (reader.failed() or readMagic != magic or readVersion != version or
+      reader.remaining() != payloadSize) {
+    return {};
+  }
+
+  GameState gameState {gMinLevel, {}};
+  reader(gameState);
+  if (reader.failed() or reader.remaining() != 0) {
+    return {};
+  }
+  return gameState;
+}
+
+// Sizes in deltas are stored as LEB128 varints, since almost all of them are
+// small.
+auto static write_varint(std::vector<u8>& bytes, std::size_t value) -> void {
+  while (value >= 0x80U) {
+    bytes.push_back(static_cast<u8>(value | 0x80U));
+    value >>= 7U;
+  }
+  bytes.push_back(static_cast<u8>(value));
+}
+
+auto static read_varint(gsl::span<u8 const> const bytes,
+                        std::size_t& position) -> std::optional<std::size_t> {
+  std::size_t value {0};
+  for (std::size_t shift {0}; shift < sizeof(value) * 8U; shift += 7U) {
+    if (position >= bytes.size()) {
+      return {};
+    }
+    auto const byte = bytes[gsl::narrow_cast<gsl::index>(position++)];
+    value |= static_cast<std::size_t>(byte & 0x7FU) << shift;
+    if ((byte & 0x80U) == 0) {
+      return value;
+    }
+  }
+  return {};
+}
+
+// Bytes past the end of the previous snapshot are XORed with zero.
+auto static xor_at(gsl::span<u8 const> const previous,
+                   gsl::span<u8 const> const current, std::size_t const i)
+    -> u8 {
+  auto const old = i < previous.size()
+                       ? previous[gsl::narrow_cast<gsl::index>(i)]
+                       : u8 {0};
+  return static_cast<u8>(current[gsl::narrow_cast<gsl::index>(i)] ^ old);
+}
+
+// The delta is the size of the current snapshot followed by pairs of a run of
+// unchanged bytes and a run of changed ones, each run prefixed by its length.
+// The changed bytes are stored XORed with the previous snapshot.
+auto encode_delta(gsl::span<u8 const> const previous,
+                  gsl::span<u8 const> const current) -> std::vector<u8> {
+  std::vector<u8> delta;
+  write_varint(delta, current.size());
+
+  std::size_t i {0};
+  while (i < current.size()) {
+    auto const unchangedStart = i;
+    while (i < current.size() and xor_at(previous, current, i) == 0) {
+      ++i;
+    }
+    if (i == current.size()) {
+      // Trailing unchanged bytes are implied by the size.
+      break;
+    }
+
+    auto const changedStart = i;
+    while (i < current.size() and xor_at(previous, current, i) != 0) {
+      ++i;
+    }
+
+    write_varint(delta, changedStart - unchangedStart);
+    write_varint(delta, i - changedStart);
+    for (auto j = changedStart; j < i; ++j) {
+      delta.push_back(xor_at(previous, current, j));
+    }
+  }
+
+  return delta;
+}
+
+auto apply_delta(gsl::span<u8 const> const previous,
+                 gsl::span<u8 const> const delta)
+    -> std::optional<std::vector<u8>> {
+  std::size_t position {0};
+  auto const size = read_varint(delta, position);
+  if (not size or *size > maxSize) {
+    return {};
+  }
+
+  std::vector<u8> current(*size, 0);
+  std::copy_n(previous.begin(), std::min(previous.size(), current.size()),
+              current.begin());
+
+  std::size_t i {0};
+  while (position < delta.size()) {
+    auto const unchanged = read_varint(delta, position);
+    auto const changed = read_varint(delta, position);
+    if (not unchanged or not changed or *unchanged > current.size() - i or
+        *changed > current.size() - i - *unchanged or
+        *changed > delta.size() - position) {
+      return {};
+    }
+
+    i += *unchanged;
+    for (auto j = i; j < i + *changed; ++j) {
+      current[j] ^= delta[gsl::narrow_cast<gsl::index>(position++)];
+    }
+    i += *changed;
+  }
+
+  return current;
+}
+
+} // namespace Snapshot
@@ -0,0 +1,297 @@
+#pragma once
+
+#include "core.hpp"
+#include "util.hpp"
+
+#include "jint.h"
+
+#include <gsl/gsl>
+
+#include <array>
+#include <chrono>
+#include <optional>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+// Games are trivially copyable (see core.hpp), so rollback and undo save and
+// restore them with plain copies. Snapshots are for when a game has to leave
+// the process, e.g. replays, keyframes or netplay: every field is written one
+// by one in little endian, so the encoding has no padding and doesn't depend
+// on the compiler's memory layout.
+//
+// The types that make up a game have a `serialize` member template which
+// calls the archive with each of their fields. The same function is used for
+// both writing and reading. Snapshots can come from other peers, so nothing
+// read is trusted: enums have to name one of their enumerators, and
+// `serialize` passes whatever else has to hold for the fields, e.g. that an
+// index is in range, to `archive.check()`. Writers ignore the checks.
+namespace Snapshot {
+
+std::array<u8, 4> static constexpr magic {'S', 'D', 'G', 'S'};
+// Must be bumped whenever a serialized field is added, removed or changed.
+u16 static constexpr version {1};
+// Comfortably more than any encoded game, header included, so that sizes read
+// from other peers can be rejected before anything is allocated for them.
+std::size_t static constexpr maxSize {4096};
+
+namespace detail {
+template <typename T>
+struct IsOptional : std::false_type {};
+template <typename T>
+struct IsOptional<std::optional<T>> : std::true_type {};
+
+template <typename T>
+struct IsArray : std::false_type {};
+template <typename T, std::size_t N>
+struct IsArray<std::array<T, N>> : std::true_type {};
+
+template <typename T>
+struct IsVariant : std::false_type {};
+template <typename... Ts>
+struct IsVariant<std::variant<Ts...>> : std::true_type {};
+
+template <typename T>
+struct IsTimePoint : std::false_type {};
+template <typename Clock, typename Duration>
+struct IsTimePoint<std::chrono::time_point<Clock, Duration>> : std::true_type {
+};
+
+template <typename T>
+struct IsPositive : std::false_type {};
+template <typename T>
+struct IsPositive<PositiveGeneric<T>> : std::true_type {
+  using Underlying = T;
+};
+
+template <typename T>
+struct IsPoint : std::false_type {};
+template <typename T>
+struct IsPoint<Point<T>> : std::true_type {};
+
+// The last enumerator of every enum that's serialized. Enums have to be
+// listed here to be read, so a new one can't be read unchecked.
+template <typename T>
+struct EnumLast;
+template <>
+struct EnumLast<Block::Kind> {
+  auto static constexpr value = Block::Kind::Garbage;
+};
+template <>
+struct EnumLast<ShapeBase::Type> {
+  auto static constexpr value = ShapeBase::Type::T;
+};
+template <>
+struct EnumLast<ShapeBase::Rotation> {
+  auto static constexpr value = ShapeBase::Rotation::r270;
+};
+template <>
+struct EnumLast<ShapeBase::RotationType> {
+  auto static constexpr value = ShapeBase::RotationType::Regular;
+};
+template <>
+struct EnumLast<BackToBackType> {
+  auto static constexpr value = BackToBackType::Tspin;
+};
+
+// Variants are restored by index, which is only known at run time.
+template <std::size_t i = 0, typename... Ts>
+auto emplace_index(std::variant<Ts...>& variant, std::size_t const index)
+    -> bool {
+  if constexpr (i < sizeof...(Ts)) {
+    if (index == i) {
+      variant.template emplace<i>();
+      return true;
+    }
+    return emplace_index<i + 1>(variant, index);
+  } else {
+    return false;
+  }
+}
+} // namespace detail
+
+class Writer {
+public:
+  template <typename... Ts>
+  auto operator()(Ts const&... values) -> void {
+    (write(values), ...);
+  }
+
+  auto check(bool /*valid*/) const noexcept -> void {}
+
+  [[nodiscard]] auto bytes() const noexcept -> std::vector<u8> const& {
+    return m_bytes;
+  }
+  [[nodiscard]] auto take_bytes() noexcept -> std::vector<u8> {
+    return std::move(m_bytes);
+  }
+
+private:
+  template <typename T>
+  auto write(T const& value) -> void {
+    if constexpr (std::is_same_v<T, bool>) {
+      write(static_cast<u8>(value ? 1 : 0));
+    } else if constexpr (std::is_enum_v<T>) {
+      write(static_cast<std::underlying_type_t<T>>(value));
+    } else if constexpr (std::is_integral_v<T>) {
+      using Unsigned = std::make_unsigned_t<T>;
+      auto const bits = static_cast<Unsigned>(value);
+      for (std::size_t i {0}; i < sizeof(T); ++i) {
+        m_bytes.push_back(static_cast<u8>(bits >> (i * 8U)));
+      }
+    } else if constexpr (detail::IsPositive<T>::value) {
+      write(static_cast<typename detail::IsPositive<T>::Underlying>(value));
+    } else if constexpr (detail::IsTimePoint<T>::value) {
+      write(static_cast<s64>(value.time_since_epoch().count()));
+    } else if constexpr (detail::IsOptional<T>::value) {
+      write(value.has_value());
+      write(value.value_or(typename T::value_type {}));
+    } else if constexpr (detail::IsArray<T>::value) {
+      for (auto const& element : value) {
+        write(element);
+      }
+    } else if constexpr (detail::IsVariant<T>::value) {
+      write(gsl::narrow_cast<u8>(value.index()));
+      std::visit([this](auto const& alternative) { write(alternative); },
+                 value);
+    } else if constexpr (detail::IsPoint<T>::value) {
+      (*this)(value.x, value.y);
+    } else if constexpr (std::is_same_v<T, Color::RGBA>) {
+      (*this)(value.r, value.g, value.b, value.a);
+    } else {
+      // serialize() only reads the fields when given a Writer.
+      const_cast<T&>(value).serialize(*this);
+    }
+  }
+
+  std::vector<u8> m_bytes;
+};
+
+class Reader {
+public:
+  explicit Reader(gsl::span<u8 const> const bytes) noexcept : m_bytes {bytes} {}
+
+  template <typename... Ts>
+  auto operator()(Ts&... values) -> void {
+    (read(values), ...);
+  }
+
+  // Fails the read if something that was read isn't valid.
+  auto check(bool const valid) noexcept -> void {
+    if (not valid) {
+      m_failed = true;
+    }
+  }
+
+  // Whether the reader ran past the end of the bytes or read something that
+  // isn't valid at any point. Fields read after running past the end are
+  // zeroed.
+  [[nodiscard]] auto failed() const noexcept -> bool { return m_failed; }
+  [[nodiscard]] auto remaining() const noexcept -> std::size_t {
+    return m_bytes.size() - m_position;
+  }
+
+private:
+  template <typename T>
+  auto read(T& value) -> void {
+    if constexpr (std::is_same_v<T, bool>) {
+      u8 byte {};
+      read(byte);
+      value = byte != 0;
+    } else if constexpr (std::is_enum_v<T>) {
+      using Underlying = std::underlying_type_t<T>;
+      Underlying underlying {};
+      read(underlying);
+      // Values past the last enumerator are replaced, so nothing that reads
+      // the field afterwards has to handle them.
+      if (underlying > static_cast<Underlying>(detail::EnumLast<T>::value)) {
+        m_failed = true;
+        underlying = 0;
+      }
+      value = static_cast<T>(underlying);
+    } else if constexpr (std::is_integral_v<T>) {
+      using Unsigned = std::make_unsigned_t<T>;
+      if (remaining() < sizeof(T)) {
+        m_failed = true;
+        m_position = m_bytes.size();
+        value = 0;
+        return;
+      }
+      Unsigned bits {0};
+      for (std::size_t i {0}; i < sizeof(T); ++i) {
+        auto const byte = m_bytes[gsl::narrow_cast<gsl::index>(m_position++)];
+        bits |= static_cast<Unsigned>(static_cast<Unsigned>(byte) << (i * 8U));
+      }
+      value = static_cast<T>(bits);
+    } else if constexpr (detail::IsPositive<T>::value) {
+      typename detail::IsPositive<T>::Underlying underlying {};
+      read(underlying);
+      value = underlying;
+    } else if constexpr (detail::IsTimePoint<T>::value) {
+      s64 count {};
+      read(count);
+      value = T {typename T::duration {count}};
+    } else if constexpr (detail::IsOptional<T>::value) {
+      bool hasValue {};
+      typename T::value_type contained {};
+      read(hasValue);
+      read(contained);
+      value = hasValue ? T {contained} : std::nullopt;
+    } else if constexpr (detail::IsArray<T>::value) {
+      for (auto& element : value) {
+        read(element);
+      }
+    } else if constexpr (detail::IsVariant<T>::value) {
+      u8 index {};
+      read(index);
+      if (not detail::emplace_index(value, index)) {
+        m_failed = true;
+        return;
+      }
+      std::visit([this](auto& alternative) { read(alternative); }, value);
+    } else if constexpr (detail::IsPoint<T>::value) {
+      (*this)(value.x, value.y);
+    } else if constexpr (std::is_same_v<T, Color::RGBA>) {
+      (*this)(value.r, value.g, value.b, value.a);
+    } else {
+      value.serialize(*this);
+    }
+  }
+
+  gsl::span<u8 const> m_bytes;
+  std::size_t m_position {0};
+  bool m_failed {false};
+};
+
+[[nodiscard]] auto fnv1a(gsl::span<u8 const> bytes) -> u64;
+
+// A hash of everything serialized from the value, e.g. to check that two
+// peers' games haven't desynced.
+template <typename T>
+[[nodiscard]] auto checksum(T const& value) -> u64 {
+  Writer writer;
+  writer(value);
+  return fnv1a(writer.bytes());
+}
+
+// The encoding starts with a header of the magic bytes, the version and the
+// size of the payload that follows it.
+[[nodiscard]] auto encode(GameState const& gameState) -> std::vector<u8>;
+// Returns nothing if the bytes aren't a snapshot of the current version.
+[[nodiscard]] auto decode(gsl::span<u8 const> bytes)
+    -> std::optional<GameState>;
+
+// Encodes `current` as its difference from `previous`. The two are XORed, so
+// unchanged bytes become zeros, and the runs of zeros are stored as just their
+// length. Consecutive snapshots of a game only differ in a few fields, so
+// their deltas are usually only a few dozen bytes.
+[[nodiscard]] auto encode_delta(gsl::span<u8 const> previous,
+                                gsl::span<u8 const> current)
+    -> std::vector<u8>;
+// Returns nothing if the delta is malformed, including if it's for a snapshot
+// bigger than maxSize.
+[[nodiscard]] auto apply_delta(gsl::span<u8 const> previous,
+                               gsl::span<u8 const> delta)
+    -> std::optional<std::vector<u8>>;
+
+} // namespace Snapshot
@@ -0,0 +1,173 @@
+#include "spectate.hpp"
+
+#include "capture.hpp"
+#include "core.hpp"
+#include "draw_software.hpp"
+#include "platform.hpp"
+
+#include "fmt/core.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace Spectate {
+
+namespace {
+
+auto constexpr level = 5;
+// Finished boards stay up for a couple of seconds before the next match.
+u64 constexpr restartDelayTicks {60 * 2};
+// Like in the headless tournament, matches between lucky bots are cut off.
+u64 constexpr maxTicks {60 * 60 * 5};
+
+} // namespace
+
+auto Layout::of(std::size_t const boardCount, Rect<int>::Size const frameSize)
+    -> Layout {
+  // Every board takes up a cell more than its size in both directions.
+  auto constexpr boardColumns = Board::columns + 1;
+  auto constexpr boardRows = Board::visibleRows + 1;
+  auto const count = static_cast<int>(std::max<std::size_t>(1, boardCount));
+
+  Layout best {};
+  for (int columns {1}; columns <= count; ++columns) {
+    auto const rows = (count + columns - 1) / columns;
+    auto const cellSize =
+        std::min(frameSize.w / (columns * boardColumns + 1),
+                 frameSize.h / (rows * boardRows + 1));
+    if (cellSize > best.cellSize) {
+      best.columns = columns;
+      best.cellSize = cellSize;
+    }
+  }
+  // The boards are cut off if they don't fit at all.
+  best.cellSize = std::max(1, best.cellSize);
+
+  auto const rows = (count + best.columns - 1) / best.columns;
+  auto const width = (best.columns * boardColumns + 1) * best.cellSize;
+  auto const height = (rows * boardRows + 1) * best.cellSize;
+  best.origin = {(frameSize.w - width) / 2 + best.cellSize,
+                 (frameSize.h - height) / 2 + best.cellSize};
+  return best;
+}
+
+auto Layout::board_rect(std::size_t const i) const -> Rect<int> {
+  auto const column = static_cast<int>(i) % columns;
+  auto const row = static_cast<int>(i) / columns;
+  return {origin.x + column * (Board::columns + 1) * cellSize,
+          origin.y + row * (Board::visibleRows + 1) * cellSize,
+          Board::columns * cellSize, Board::visibleRows * cellSize};
+}
+
+Wall::Game::Game(Randomizer::Engine::result_type const seed)
+    : match {level, seed}, bots {Versus::RandomBot {seed * 2 + 1},
+                                 Versus::RandomBot {seed * 2 + 2}} {}
+
+Wall::Wall(std::size_t const boardCount) : m_boards(boardCount) {
+  auto const gameCount = (boardCount + 1) / 2;
+  m_games.reserve(gameCount);
+  for (std::size_t i {0}; i < gameCount; ++i) {
+    m_games.emplace_back(m_nextSeed++);
+  }
+  for (std::size_t i {0}; i < m_boards.size(); ++i) {
+    update_board(i);
+  }
+}
+
+auto Wall::step() -> void {
+  for (auto& game : m_games) {
+    auto& match = game.match;
+    if (match.is_over() or match.tick() >= maxTicks) {
+      if (++game.ticksSinceOver >= restartDelayTicks) {
+        game = Game {m_nextSeed++};
+      }
+      continue;
+    }
+    match.step({game.bots[0].next_input(), game.bots[1].next_input()});
+  }
+  for (std::size_t i {0}; i < m_boards.size(); ++i) {
+    update_board(i);
+  }
+}
+
+auto Wall::update_board(std::size_t const i) -> void {
+  auto const& gameState = m_games[i / 2].match.player(i % 2).gameState;
+  auto constexpr hiddenRows = Board::rows - Board::visibleRows;
+
+  BoardView::Cells cells {};
+  std::copy_n(&gameState.board.block_at(hiddenRows * Board::columns),
+              cells.size(), cells.begin());
+  if (not gameState.gameOver) {
+    auto const& shape = gameState.currentShape;
+    for (auto const& position : shape.get_absolute_block_positions()) {
+      auto const y = position.y - hiddenRows;
+      if (y >= 0 and y < Board::visibleRows and position.x >= 0 and
+          position.x < Board::columns) {
+        cells[static_cast<std::size_t>(y * Board::columns + position.x)] =
+            Block::from(shape.type());
+      }
+    }
+  }
+
+  auto& board = m_boards[i];
+  auto const same_kind = [](Block const lhs, Block const rhs) {
+    return lhs.kind == rhs.kind;
+  };
+  if (not std::equal(cells.begin(), cells.end(), board.cells.begin(),
+                     same_kind)) {
+    board.cells = cells;
+    ++board.version;
+  }
+}
+
+auto run(std::size_t const boardCount) -> void {
+  using Clock = std::chrono::steady_clock;
+
+  Wall wall {boardCount};
+  auto const offscreen = get_render_mode() == RenderMode::offscreen;
+  std::vector<Clock::duration> drawTimes {};
+
+  auto running = true;
+  while (running) {
+    auto const frameStart = Clock::now();
+
+    Event event {};
+    while ((event = get_event()).type != Event::Type::None) {
+      if (event.type == Event::Type::Quit) {
+        running = false;
+      } else if (event.type == Event::Type::Increase_window_size) {
+        change_window_scale(get_window_scale() + 1);
+      } else if (event.type == Event::Type::Decrease_window_size) {
+        change_window_scale(get_window_scale() - 1);
+      }
+    }
+
+    wall.step();
+    auto const drawStart = Clock::now();
+    auto const rects = SoftwareRender::draw_wall(wall.boards());
+    drawTimes.push_back(Clock::now() - drawStart);
+    Capture::submit(get_back_buffer());
+    swap_buffer(rects);
+
+    // Offscreen frames are drawn as fast as possible.
+    if (not offscreen) {
+      std::this_thread::sleep_until(frameStart +
+                                    ProgramState::targetFrameTime);
+    }
+  }
+
+  if (drawTimes.empty()) {
+    return;
+  }
+  std::sort(drawTimes.begin(), drawTimes.end());
+  auto const milliseconds = [&drawTimes](std::size_t const p) {
+    auto const i = std::min(drawTimes.size() - 1, drawTimes.size() * p / 100);
+    return std::chrono::duration<double, std::milli> {drawTimes[i]}.count();
+  };
+  fmt::print("Drew {} frames of {} boards, p50 {:.3f} ms, p99 {:.3f} ms\n",
+             drawTimes.size(), boardCount, milliseconds(50),
+             milliseconds(99));
+}
+
+} // namespace Spectate
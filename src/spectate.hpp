@@ -0,0 +1,75 @@
+#pragma once
+
+#include "board.hpp"
+#include "util.hpp"
+#include "versus.hpp"
+
+#include "jint.h"
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// A wall of live boards from many versus matches between bots at once, e.g.
+// to watch a tournament. Every board is reduced to the kind of block in each
+// of its visible cells, so the renderer only has to redraw a board when its
+// cells changed.
+namespace Spectate {
+
+std::size_t constexpr maxBoards {100};
+
+struct BoardView {
+  // The visible rows of the board, top to bottom, current shape included.
+  using Cells = std::array<Block, Board::columns * Board::visibleRows>;
+
+  Cells cells {};
+  // Changes whenever the cells do.
+  u64 version {0};
+};
+
+// Where the boards go in a frame. Boards are laid out in a grid with a cell's
+// worth of space around each of them, picking the amount of columns that
+// gives the biggest cells.
+struct Layout {
+  int columns {1};
+  int cellSize {0};
+  Point<int> origin {};
+
+  [[nodiscard]] auto static of(std::size_t boardCount,
+                               Rect<int>::Size frameSize) -> Layout;
+  [[nodiscard]] auto board_rect(std::size_t i) const -> Rect<int>;
+};
+
+// Plays pairs of bots against each other, one tick per step, and starts a new
+// match a while after one is over.
+class Wall {
+public:
+  explicit Wall(std::size_t boardCount);
+
+  auto step() -> void;
+
+  [[nodiscard]] auto boards() const -> std::vector<BoardView> const& {
+    return m_boards;
+  }
+
+private:
+  struct Game {
+    explicit Game(Randomizer::Engine::result_type seed);
+
+    Versus::Match<2> match;
+    std::array<Versus::RandomBot, 2> bots;
+    u64 ticksSinceOver {0};
+  };
+
+  auto update_board(std::size_t i) -> void;
+
+  std::vector<Game> m_games {};
+  std::vector<BoardView> m_boards {};
+  Randomizer::Engine::result_type m_nextSeed {1};
+};
+
+// Shows `boardCount` boards until the window is closed. Has to be run in
+// software or offscreen mode.
+auto run(std::size_t boardCount) -> void;
+
+} // namespace Spectate
@@ -1,8 +1,29 @@
 #include "tests.hpp"
 
+#include "blend.hpp"
 #include "board.hpp"
+#include "capture.hpp"
+#include "check.hpp"
+#include "damage.hpp"
+#include "draw_software.hpp"
+#include "draw_terminal.hpp"
+#include "font.hpp"
+#include "rollback.hpp"
+#include "shape.hpp"
+#include "shape_pool.hpp"
+#include "snapshot.hpp"
+#include "spectate.hpp"
+#include "thread_pool.hpp"
+#include "versus.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace tests {
 auto remove_full_rows() -> void {
@@ -41,5 +62,735 @@ auto remove_full_rows() -> void {
   /* } */
 }
 
-auto run() -> void { remove_full_rows(); }
+template <typename System>
+auto static layouts_have_all_blocks() -> void {
+  for (std::size_t type {0}; type < ShapeBase::typeCount; ++type) {
+    for (std::size_t rotation {0}; rotation < 4; ++rotation) {
+      auto const& layout =
+          System::layout(static_cast<ShapeBase::Type>(type),
+                         static_cast<ShapeBase::Rotation>(rotation));
+      auto const blocks = std::count(layout.cbegin(), layout.cend(), true);
+      CHECK(static_cast<std::size_t>(blocks) == ShapeBase::blockCount);
+    }
+  }
+}
+
+// An upright I shape pushed against the left wall can only rotate back by
+// being kicked away from it.
+template <typename System>
+[[nodiscard]] auto static rotate_i_against_wall()
+    -> std::optional<ShapeBase::RotationType> {
+  Board const board {};
+  BasicShape<System> shape {ShapeBase::Type::I};
+  board.rotate_shape(shape, ShapeBase::RotationDirection::Right);
+  while (board.try_move(shape, V2::left())) {
+    // Intentionally empty body.
+  }
+  return board.rotate_shape(shape, ShapeBase::RotationDirection::Left);
+}
+
+auto rotation_systems() -> void {
+  layouts_have_all_blocks<RotationSystem::SRS>();
+  layouts_have_all_blocks<RotationSystem::ARS>();
+  layouts_have_all_blocks<RotationSystem::NoKicks>();
+
+  // Every shape spawns with its top in the same row in both systems.
+  auto const top = [](auto const& shape) {
+    auto const positions = shape.get_absolute_block_positions();
+    auto const highest = std::min_element(
+        positions.begin(), positions.end(),
+        [](auto const& lhs, auto const& rhs) { return lhs.y < rhs.y; });
+    return highest->y;
+  };
+  for (std::size_t type {0}; type < ShapeBase::typeCount; ++type) {
+    auto const shapeType = static_cast<ShapeBase::Type>(type);
+    CHECK(top(BasicShape<RotationSystem::SRS> {shapeType}) ==
+          top(BasicShape<RotationSystem::ARS> {shapeType}));
+  }
+
+  CHECK(rotate_i_against_wall<RotationSystem::SRS>() ==
+        ShapeBase::RotationType::Wallkick);
+  CHECK(not rotate_i_against_wall<RotationSystem::ARS>());
+  CHECK(not rotate_i_against_wall<RotationSystem::NoKicks>());
+}
+
+auto shape_pool() -> void {
+  // A deep preview has to match the shapes that are actually dealt later.
+  for (auto const& randomizer :
+       {Randomizer::Any {Randomizer::SevenBag {}},
+        Randomizer::Any {Randomizer::FourteenBag {}},
+        Randomizer::Any {Randomizer::History {}},
+        Randomizer::Any {Randomizer::Random {}}}) {
+    auto constexpr depth = std::size_t {40};
+    ShapePool pool {randomizer};
+    std::array<Shape::Type, depth> preview {};
+    for (std::size_t i {0}; i < depth; ++i) {
+      preview[i] = pool.peek(i);
+    }
+    CHECK(pool.current_shape().type() == preview[0]);
+    for (std::size_t i {1}; i < depth; ++i) {
+      CHECK(pool.next_shape().type() == preview[i]);
+    }
+  }
+
+  // Every bag of 7 contains each shape exactly once.
+  ShapePool pool {Randomizer::SevenBag {}};
+  for (std::size_t bag {0}; bag < 4; ++bag) {
+    std::array<int, Shape::typeCount> counts {};
+    for (std::size_t i {0}; i < Shape::typeCount; ++i) {
+      ++counts[static_cast<std::size_t>(pool.peek(bag * Shape::typeCount + i))];
+    }
+    CHECK(std::all_of(counts.cbegin(), counts.cend(),
+                      [](auto const count) { return count == 1; }));
+  }
+
+  // The game keeps the previewed shapes generated, so the renderers can draw
+  // them from a const pool.
+  GameClock::time_point const epoch {};
+  GameState gameState {gMinLevel, epoch};
+  Input input {};
+  input.set(Input::Action::Drop);
+  for (auto tick = 0; tick < 10; ++tick) {
+    CHECK(gameState.shapePool.generated() > gPreviewShapeCount);
+    apply_input(gameState, input, epoch);
+    (void)update_game(gameState, epoch);
+  }
+}
+
+auto versus() -> void {
+  LockResult tetris {};
+  tetris.clearType = ClearType::Tetris;
+  tetris.rowsCleared = 4;
+  tetris.comboCounter = 0;
+  CHECK(Versus::attack_lines(tetris) == 4);
+  tetris.backToBack = true;
+  tetris.comboCounter = 2;
+  CHECK(Versus::attack_lines(tetris) == 4 + 1 + 1);
+
+  // Attacks cancel the oldest incoming garbage first.
+  Versus::GarbageQueue queue {};
+  queue.push({2, 0});
+  queue.push({3, 5});
+  CHECK(queue.cancel(3) == 0);
+  CHECK(queue.total_lines() == 2);
+  CHECK(queue.begin()->holeColumn == 5);
+  CHECK(queue.cancel(4) == 2);
+  CHECK(queue.empty());
+
+  Board board {};
+  CHECK(board.add_garbage_rows(2, 3));
+  for (u8 x {0}; x < Board::columns; ++x) {
+    auto const& block =
+        board.block_at((Board::rows - 1) * Board::columns + x);
+    CHECK(block.is_active() == (x != 3));
+  }
+  CHECK(not board.add_garbage_rows(Board::rows, 0));
+
+  // The same seed and inputs always play out the same match.
+  auto const play = []() {
+    Versus::Match<2> match {1, 42};
+    Input drop {};
+    drop.set(Input::Action::Drop);
+    for (auto tick = 0; tick < 600; ++tick) {
+      match.step({drop, Input {}});
+    }
+    return match;
+  };
+  auto const first = play();
+  auto const second = play();
+  CHECK(first.player(0).gameState.score == second.player(0).gameState.score);
+  CHECK(first.player(0).gameState.currentShape.pos.y ==
+        second.player(0).gameState.currentShape.pos.y);
+}
+
+auto snapshots() -> void {
+  GameClock::time_point const epoch {};
+  GameState gameState {gMinLevel, epoch, 7};
+  Input input {};
+  input.set(Input::Action::Move_left);
+  input.set(Input::Action::Drop);
+  for (auto tick = 0; tick < 10; ++tick) {
+    apply_input(gameState, input, epoch);
+    (void)update_game(gameState, epoch);
+  }
+
+  auto const bytes = Snapshot::encode(gameState);
+  auto decoded = Snapshot::decode(bytes);
+  CHECK(decoded);
+  CHECK(Snapshot::encode(*decoded) == bytes);
+
+  // The decoded game has to play out exactly like the original, with the
+  // clocks running so that gravity and locking get restored too.
+  for (auto tick = 1; tick <= 10; ++tick) {
+    auto const now = epoch + tick * GameState::softDropDelay;
+    apply_input(gameState, input, now);
+    apply_input(*decoded, input, now);
+    (void)update_game(gameState, now);
+    (void)update_game(*decoded, now);
+  }
+  auto const next = Snapshot::encode(gameState);
+  CHECK(Snapshot::encode(*decoded) == next);
+
+  auto const delta = Snapshot::encode_delta(bytes, next);
+  CHECK(delta.size() < next.size());
+  CHECK(Snapshot::apply_delta(bytes, delta) == next);
+  CHECK(Snapshot::encode_delta(next, next).size() == 2);
+  CHECK(Snapshot::apply_delta({}, Snapshot::encode_delta({}, next)) == next);
+  // Deltas claiming to be for a huge snapshot are rejected without trying to
+  // allocate it.
+  std::vector<u8> oversized(9, 0xFFU);
+  oversized.push_back(0x7FU);
+  CHECK(not Snapshot::apply_delta(bytes, oversized));
+  std::vector<u8> const tooBig(Snapshot::maxSize + 1);
+  CHECK(not Snapshot::apply_delta(bytes, Snapshot::encode_delta({}, tooBig)));
+
+  auto wrongVersion = bytes;
+  wrongVersion[Snapshot::magic.size()] ^= 0xFFU;
+  CHECK(not Snapshot::decode(wrongVersion));
+  CHECK(not Snapshot::decode(gsl::span<u8 const> {bytes}.first(
+      static_cast<gsl::index>(bytes.size() - 1))));
+
+  // Values that would be out of range once decoded fail the whole snapshot.
+  auto withBlock = gameState;
+  withBlock.board.block_at(0) = Block {Block::Kind::Garbage};
+  auto badKind = Snapshot::encode(withBlock);
+  auto const blockByte = std::mismatch(next.begin(), next.end(),
+                                       badKind.begin()).second;
+  CHECK(blockByte != badKind.end());
+  *blockByte = static_cast<u8>(Block::Kind::Garbage) + 1;
+  CHECK(not Snapshot::decode(badKind));
+
+  Snapshot::Writer writer {};
+  writer(gameState.shapePool);
+  auto badPool = writer.bytes();
+  // The size is the last field.
+  badPool.back() = ShapePool::capacity + 1;
+  ShapePool pool {};
+  Snapshot::Reader poolReader {badPool};
+  poolReader(pool);
+  CHECK(poolReader.failed());
+
+  // A bag's index comes after its shapes.
+  Snapshot::Writer bagWriter {};
+  bagWriter(std::array<Shape::Type, Shape::typeCount> {}, u8 {8});
+  Randomizer::SevenBag bag {};
+  Snapshot::Reader bagReader {bagWriter.bytes()};
+  bagReader(bag);
+  CHECK(bagReader.failed());
+}
+
+auto rollback() -> void {
+  Rollback::Match const start {1, 3};
+  std::array sessions {Rollback::Session {start, 0, 1},
+                       Rollback::Session {start, 1, 1}};
+  std::array bots {Versus::RandomBot {1}, Versus::RandomBot {2}};
+
+  // Each peer only sees the other's inputs a few ticks late.
+  u64 constexpr latency {4};
+  u64 constexpr ticks {300};
+  std::vector<Rollback::Match::Inputs> confirmedInputs {};
+  auto const deliver = [&sessions, &confirmedInputs](u64 const tick) {
+    Rollback::Match::Inputs inputs {};
+    for (std::size_t i {0}; i < sessions.size(); ++i) {
+      inputs[i] = *sessions[i].local_input(tick);
+      sessions[1 - i].add_remote_input(tick, inputs[i]);
+    }
+    confirmedInputs.push_back(inputs);
+  };
+  for (u64 tick {0}; tick < ticks; ++tick) {
+    for (std::size_t i {0}; i < sessions.size(); ++i) {
+      CHECK(sessions[i].can_advance());
+      sessions[i].advance(bots[i].next_input());
+    }
+    if (tick >= latency) {
+      deliver(tick - latency);
+    }
+  }
+  for (auto tick = ticks - latency; tick < sessions[0].local_input_end();
+       ++tick) {
+    deliver(tick);
+  }
+
+  // Replaying the confirmed inputs without any prediction has to end up in
+  // the same state.
+  Rollback::Match reference {start};
+  for (u64 tick {0}; tick < ticks; ++tick) {
+    reference.step(confirmedInputs[tick]);
+  }
+  for (auto& session : sessions) {
+    session.resimulate();
+    CHECK(session.confirmed_tick() == ticks);
+    CHECK(session.stats().rollbacks > 0);
+    CHECK(not session.desync_tick());
+    CHECK(Snapshot::checksum(session.match()) == Snapshot::checksum(reference));
+  }
+
+  auto const [checksumTick, checksum] = *sessions[1].latest_checksum();
+  sessions[0].add_remote_checksum(checksumTick, checksum);
+  CHECK(not sessions[0].desync_tick());
+  sessions[0].add_remote_checksum(checksumTick, checksum + 1);
+  CHECK(sessions[0].desync_tick() == checksumTick);
+}
+
+auto thread_pool() -> void {
+  ThreadPool pool {4};
+  // Reusing the pool has to run every job of every batch exactly once.
+  for (auto batch = 0; batch < 100; ++batch) {
+    std::vector<std::atomic<int>> counts(37);
+    pool.for_each(counts.size(),
+                  [&counts](std::size_t const i) { ++counts[i]; });
+    CHECK(all_of(counts, [](auto const& count) { return count == 1; }));
+  }
+
+  std::vector<std::atomic<int>> rows(1000);
+  std::atomic<int> jobs {0};
+  pool.for_each_row_range(rows.size(), 100, [&](std::size_t const start,
+                                                std::size_t const end) {
+    ++jobs;
+    for (auto row = start; row < end; ++row) {
+      ++rows[row];
+    }
+  });
+  CHECK(all_of(rows, [](auto const& count) { return count == 1; }));
+  // 1000 rows of 100 pixels are split by pixel count, not by thread count.
+  auto const rowsPerJob = ThreadPool::minPixelsPerJob / 100;
+  CHECK(jobs == static_cast<int>((rows.size() + rowsPerJob - 1) / rowsPerJob));
+}
+
+auto blend() -> void {
+  // Every code path has to match blending a channel at a time.
+  auto const expected = [](u8 const background, u8 const foreground,
+                           uint const alpha) {
+    return static_cast<u8>((background * (255 - alpha) + foreground * alpha +
+                            127) /
+                           255);
+  };
+
+  Randomizer::Engine engine {5};
+  auto const check_format = [&](auto const formatConstant) {
+    auto constexpr format = decltype(formatConstant)::value;
+    auto constexpr bpp = bytes_per_pixel(format);
+    for (std::size_t count {0}; count < 40; ++count) {
+      for (auto const alpha : {0U, 1U, 77U, 128U, 254U, 255U}) {
+        Color::RGBA const color {static_cast<u8>(engine()),
+                                 static_cast<u8>(engine()),
+                                 static_cast<u8>(engine()),
+                                 static_cast<u8>(alpha)};
+        std::array const channels {u8 {color.b}, u8 {color.g}, u8 {color.r},
+                                   u8 {255}};
+
+        std::vector<u8> pixels(count * bpp);
+        std::vector<u8> coverage(count);
+        for (std::size_t i {0}; i < pixels.size(); ++i) {
+          pixels[i] = static_cast<u8>(engine());
+        }
+        for (auto& c : coverage) {
+          c = static_cast<u8>(engine() % 3 == 0 ? 0 : engine());
+        }
+
+        auto spanPixels = pixels;
+        Blend::span<format>(spanPixels.data(), count, color);
+        auto coveragePixels = pixels;
+        Blend::coverage_span<format>(coveragePixels.data(), coverage.data(),
+                                     count, color);
+        for (std::size_t i {0}; i < pixels.size(); ++i) {
+          auto const channel = channels[i % bpp];
+          CHECK(spanPixels[i] == expected(pixels[i], channel, alpha));
+          auto const coverageAlpha = (coverage[i / bpp] * alpha + 127) / 255;
+          CHECK(coveragePixels[i] ==
+                expected(pixels[i], channel, coverageAlpha));
+        }
+      }
+    }
+  };
+  check_format(std::integral_constant<PixelFormat, PixelFormat::XRGB8888> {});
+  check_format(std::integral_constant<PixelFormat, PixelFormat::ARGB8888> {});
+  check_format(std::integral_constant<PixelFormat, PixelFormat::BGR24> {});
+
+  // RGB565 is blended at 8 bits per channel and then truncated.
+  std::vector<u16> pixels {0x0000, 0xFFFF, 0xF800, 0x07E0, 0x001F, 0x1234};
+  auto const unpack = [](u16 const p) {
+    uint const r {(p >> 11U) & 0x1FU};
+    uint const g {(p >> 5U) & 0x3FU};
+    uint const b {p & 0x1FU};
+    return std::array {(r << 3U) | (r >> 2U), (g << 2U) | (g >> 4U),
+                       (b << 3U) | (b >> 2U)};
+  };
+  for (auto const alpha : {0U, 77U, 255U}) {
+    Color::RGBA const color {0x80U, 0x40U, 0xFFU, static_cast<u8>(alpha)};
+    auto blended = pixels;
+    Blend::span<PixelFormat::RGB565>(reinterpret_cast<u8*>(blended.data()),
+                                     blended.size(), color);
+    for (std::size_t i {0}; i < pixels.size(); ++i) {
+      auto const channels = unpack(pixels[i]);
+      auto const r = expected(static_cast<u8>(channels[0]), 0x80U, alpha);
+      auto const g = expected(static_cast<u8>(channels[1]), 0x40U, alpha);
+      auto const b = expected(static_cast<u8>(channels[2]), 0xFFU, alpha);
+      CHECK(blended[i] == ((r >> 3U) << 11U | (g >> 2U) << 5U | (b >> 3U)));
+    }
+  }
+}
+
+auto rect_rasterization() -> void {
+  // A padded buffer, so rows that ignore the pitch show up as well.
+  uint constexpr width {10};
+  uint constexpr height {8};
+  u8 constexpr bpp {3};
+  uint constexpr pitch {width * bpp + 2};
+  Color::RGBA const color {255U, 255U, 255U, 128U};
+
+  for (int const borderSize : {0, 1, 2, 3, 6}) {
+    for (int x {-4}; x <= 8; x += 3) {
+      for (int y {-4}; y <= 6; y += 2) {
+        for (int const size : {1, 3, 7}) {
+          std::vector<u8> pixels(pitch * height);
+          BackBuffer buf {pixels.data(), {width, height}, pitch, bpp,
+                          PixelFormat::BGR24};
+          Rect<int> const sqr {x, y, size + 2, size};
+          SoftwareRender::draw_hollow_square(buf, sqr, color, borderSize);
+
+          Rect<int> const inner {x + borderSize, y + borderSize,
+                                 sqr.w - borderSize * 2,
+                                 sqr.h - borderSize * 2};
+          for (uint py {0}; py < height; ++py) {
+            for (uint i {0}; i < pitch; ++i) {
+              Point<int> const point {static_cast<int>(i / bpp),
+                                      static_cast<int>(py)};
+              auto const inBorder = i < width * bpp and
+                                    point_is_in_rect(point, sqr) and
+                                    not point_is_in_rect(point, inner);
+              // Blending twice would darken the corners.
+              CHECK(pixels[py * pitch + i] == (inBorder ? 128 : 0));
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+auto damage() -> void {
+  using Damage::tileSize;
+  Damage::Tracker tracker {};
+  Rect<int>::Size const size {tileSize * 4 + 5, tileSize * 3};
+  auto const frame = [&](std::vector<std::pair<Rect<int>, u64>> const& items) {
+    tracker.begin_frame(size);
+    for (auto const& [rect, hash] : items) {
+      tracker.add(rect, hash);
+    }
+    return tracker.end_frame();
+  };
+  auto const is_rect = [](Rect<int> const& r, Rect<int> const& expected) {
+    return r.x == expected.x and r.y == expected.y and r.w == expected.w and
+           r.h == expected.h;
+  };
+
+  Rect<int> const background {0, 0, size.w, size.h};
+  Rect<int> const piece {tileSize + 3, tileSize + 3, 4, 4};
+
+  // The first frame is damaged everywhere, and clipped to the frame.
+  auto damaged = frame({{background, 0}, {piece, 1}});
+  CHECK(damaged.size() == 3);
+  CHECK(is_rect(damaged[0], {0, 0, size.w, tileSize}));
+  CHECK(is_rect(damaged[2], {0, tileSize * 2, size.w, tileSize}));
+  CHECK(Damage::merge_vertically(damaged).size() == 1);
+
+  CHECK(frame({{background, 0}, {piece, 1}}).empty());
+
+  // Changing what's drawn, or the order it's drawn in, damages the tiles.
+  damaged = frame({{background, 0}, {piece, 2}});
+  CHECK(damaged.size() == 1);
+  CHECK(is_rect(damaged[0], {tileSize, tileSize, tileSize, tileSize}));
+  damaged = frame({{piece, 2}, {background, 0}});
+  CHECK(damaged.size() == 1);
+
+  // Moving something damages where it was and where it is, and a run of
+  // tiles becomes a single rect.
+  frame({{background, 0}, {piece, 2}});
+  auto movedPiece = piece;
+  movedPiece.x += tileSize;
+  damaged = frame({{background, 0}, {movedPiece, 2}});
+  CHECK(damaged.size() == 1);
+  CHECK(is_rect(damaged[0], {tileSize, tileSize, tileSize * 2, tileSize}));
+
+  tracker.invalidate();
+  CHECK(frame({{background, 0}}).size() == 3);
+
+  // Something hashed per tile only damages the tiles whose hash changed.
+  auto const per_tile_frame = [&](Point<int> const changedTile) {
+    tracker.begin_frame(size);
+    tracker.add_per_tile(background, [&](Rect<int> const tile) {
+      return static_cast<u64>(tile.x == changedTile.x * tileSize and
+                              tile.y == changedTile.y * tileSize);
+    });
+    return tracker.end_frame();
+  };
+  per_tile_frame({0, 0});
+  damaged = per_tile_frame({2, 1});
+  CHECK(damaged.size() == 2);
+  CHECK(is_rect(damaged[0], {0, 0, tileSize, tileSize}));
+  CHECK(is_rect(damaged[1], {tileSize * 2, tileSize, tileSize, tileSize}));
+  // The tiles at the edges are clipped to the frame.
+  damaged = per_tile_frame({4, 2});
+  CHECK(damaged.size() == 2);
+  CHECK(is_rect(damaged[1], {tileSize * 4, tileSize * 2, 5, tileSize}));
+
+  // Tiles are binned by the columns and rows of tiles a rect overlaps.
+  auto const tiles = Damage::overlapped_tiles({-5, tileSize - 1, 7, 2}, size);
+  CHECK(tiles and is_rect(*tiles, {0, 0, 1, 2}));
+  CHECK(not Damage::overlapped_tiles({size.w, 0, 5, 5}, size));
+}
+
+auto capture() -> void {
+  // Every code path has to match converting a pixel, or the average of a 2
+  // by 2 block of them, at a time.
+  auto const luma = [](int const r, int const g, int const b) {
+    return (77 * r + 150 * g + 29 * b + 128) / 256;
+  };
+  auto const chroma = [](int const weighed) {
+    return (weighed + 127 + 128 * 256) / 256;
+  };
+
+  Randomizer::Engine engine {7};
+  for (auto const format : {PixelFormat::XRGB8888, PixelFormat::BGR24}) {
+    auto const bpp = bytes_per_pixel(format);
+    for (auto const size : {Rect<int>::Size {1, 1}, Rect<int>::Size {8, 2},
+                            Rect<int>::Size {13, 5}, Rect<int>::Size {19, 4}}) {
+      auto const pitch = static_cast<std::size_t>(size.w * bpp + 3);
+      std::vector<u8> pixels(pitch * static_cast<std::size_t>(size.h));
+      for (auto& p : pixels) {
+        p = static_cast<u8>(engine());
+      }
+      auto const chromaWidth = (size.w + 1) / 2;
+      auto const chromaHeight = (size.h + 1) / 2;
+      std::vector<u8> y(static_cast<std::size_t>(size.w * size.h));
+      std::vector<u8> u(static_cast<std::size_t>(chromaWidth * chromaHeight));
+      auto v = u;
+      Capture::to_yuv420(pixels.data(), pitch, format, size, y.data(),
+                         u.data(), v.data());
+
+      // Blocks at an odd edge use the last row or column twice.
+      auto const channel = [&](int x, int row, int const c) {
+        x = std::min(x, size.w - 1);
+        row = std::min(row, size.h - 1);
+        return int {pixels[static_cast<std::size_t>(row) * pitch +
+                           static_cast<std::size_t>(x * bpp + c)]};
+      };
+      for (int row {0}; row < size.h; ++row) {
+        for (int x {0}; x < size.w; ++x) {
+          CHECK(y[static_cast<std::size_t>(row * size.w + x)] ==
+                luma(channel(x, row, 2), channel(x, row, 1),
+                     channel(x, row, 0)));
+        }
+      }
+      for (int row {0}; row < chromaHeight; ++row) {
+        for (int x {0}; x < chromaWidth; ++x) {
+          auto const average = [&](int const c) {
+            return (channel(x * 2, row * 2, c) +
+                    channel(x * 2 + 1, row * 2, c) +
+                    channel(x * 2, row * 2 + 1, c) +
+                    channel(x * 2 + 1, row * 2 + 1, c) + 2) /
+                   4;
+          };
+          auto const r = average(2);
+          auto const g = average(1);
+          auto const b = average(0);
+          auto const i = static_cast<std::size_t>(row * chromaWidth + x);
+          CHECK(u[i] == chroma(128 * b - 43 * r - 85 * g));
+          CHECK(v[i] == chroma(128 * r - 107 * g - 21 * b));
+        }
+      }
+    }
+  }
+
+  // Gray stays gray.
+  std::array<u8, 4> const white {255, 255, 255, 255};
+  std::array<u8, 3> yuv {};
+  Capture::to_yuv420(white.data(), 4, PixelFormat::XRGB8888, {1, 1}, &yuv[0],
+                     &yuv[1], &yuv[2]);
+  CHECK(yuv[0] == 255 and yuv[1] == 128 and yuv[2] == 128);
+
+  // Frames that don't match the first one are dropped.
+  auto* const file = std::tmpfile();
+  CHECK(file);
+  uint constexpr width {4};
+  uint constexpr height {2};
+  std::vector<u8> pixels(width * height * 4);
+  BackBuffer const bb {pixels.data(), {width, height}, width * 4, u8 {4},
+                       PixelFormat::XRGB8888};
+  BackBuffer const smaller {pixels.data(), {width, 1U}, width * 4, u8 {4},
+                            PixelFormat::XRGB8888};
+  {
+    Capture::Recorder recorder {file, 60};
+    for (int i {0}; i < 3; ++i) {
+      pixels[0] = static_cast<u8>(i);
+      CHECK(recorder.submit(bb));
+    }
+    CHECK(not recorder.submit(smaller));
+    recorder.finish();
+    CHECK(recorder.written_frames() == 3);
+    CHECK(recorder.dropped_frames() == 1);
+  }
+
+  std::string const header {"YUV4MPEG2 W4 H2 F60:1 Ip A1:1 C420jpeg\n"};
+  std::string const frameHeader {"FRAME\n"};
+  std::rewind(file);
+  std::string contents {};
+  for (int c {}; (c = std::fgetc(file)) != EOF;) {
+    contents.push_back(static_cast<char>(c));
+  }
+  std::fclose(file);
+  CHECK(contents.compare(0, header.size(), header) == 0);
+  CHECK(contents.size() ==
+        header.size() + 3 * (frameHeader.size() + width * height + 2 * 2));
+
+  // Blocking recorders wait for the writer instead of dropping frames.
+  auto* const blockingFile = std::tmpfile();
+  CHECK(blockingFile);
+  {
+    Capture::Recorder recorder {blockingFile, 60, true};
+    auto constexpr frames = Capture::Recorder::slotCount * 4;
+    for (std::size_t i {0}; i < frames; ++i) {
+      CHECK(recorder.submit(bb));
+    }
+    recorder.finish();
+    CHECK(recorder.written_frames() == frames);
+    CHECK(recorder.dropped_frames() == 0);
+  }
+  std::fclose(blockingFile);
+}
+
+auto terminal_screen() -> void {
+  using TerminalRender::Cell;
+  using TerminalRender::Rgb;
+
+  TerminalRender::Screen screen {};
+  screen.resize({3, 2});
+  for (int y {0}; y < 2; ++y) {
+    for (int x {0}; x < 3; ++x) {
+      screen.cell(x, y) = Cell {Rgb {10, 20, 30}, Rgb {40, 50, 60}};
+    }
+  }
+  screen.cell(2, 1).character = 'A';
+
+  // Every cell is sent the first time, with the colors set only once.
+  std::string first {};
+  screen.present(first);
+  auto const count = [](std::string const& haystack, std::string const& s) {
+    std::size_t n {0};
+    for (auto i = haystack.find(s); i != std::string::npos;
+         i = haystack.find(s, i + 1)) {
+      ++n;
+    }
+    return n;
+  };
+  CHECK(count(first, "\xe2\x96\x80") == 5);
+  CHECK(count(first, "A") == 1);
+  CHECK(count(first, "38;2;10;20;30") == 1);
+
+  // An identical frame sends nothing.
+  std::string second {};
+  screen.present(second);
+  CHECK(second.empty());
+
+  // Only the changed cell is sent.
+  screen.cell(2, 0).bottom = Rgb {1, 2, 3};
+  std::string third {};
+  screen.present(third);
+  CHECK(count(third, "\xe2\x96\x80") == 1);
+  CHECK(third.find("\x1b[1;3H") != std::string::npos);
+  CHECK(third.find("48;2;1;2;3") != std::string::npos);
+  CHECK(third.size() < first.size() / 2);
+
+  // Resizing clears the cells and sends all of them again.
+  screen.resize({3, 2});
+  std::string fourth {};
+  screen.present(fourth);
+  CHECK(count(fourth, "\xe2\x96\x80") == 6);
+}
+
+auto spectate() -> void {
+  // The boards fit in the frame without overlapping, for every amount.
+  for (auto const frameSize :
+       {Rect<int>::Size {1920, 1080}, Rect<int>::Size {170, 260}}) {
+    for (std::size_t count {1}; count <= Spectate::maxBoards; ++count) {
+      auto const layout = Spectate::Layout::of(count, frameSize);
+      CHECK(layout.cellSize >= 1);
+      for (std::size_t i {0}; i < count; ++i) {
+        auto const rect = layout.board_rect(i);
+        CHECK(rect.x >= 0 and rect.x + rect.w <= frameSize.w);
+        CHECK(rect.y >= 0 and rect.y + rect.h <= frameSize.h);
+        if (i > 0) {
+          CHECK(not rect_intersection(rect, layout.board_rect(i - 1)));
+        }
+      }
+    }
+  }
+  auto const single = Spectate::Layout::of(1, {170, 260});
+  CHECK(single.cellSize == 11);
+
+  // A board's version changes exactly when its cells do.
+  Spectate::Wall wall {5};
+  auto changes = 0;
+  for (int tick {0}; tick < 600; ++tick) {
+    auto const before = wall.boards();
+    wall.step();
+    for (std::size_t i {0}; i < before.size(); ++i) {
+      auto const& board = wall.boards()[i];
+      auto const same = std::equal(
+          board.cells.begin(), board.cells.end(), before[i].cells.begin(),
+          [](Block const lhs, Block const rhs) {
+            return lhs.kind == rhs.kind;
+          });
+      CHECK(same == (board.version == before[i].version));
+      changes += same ? 0 : 1;
+    }
+  }
+  CHECK(changes > 0);
+}
+
+auto baked_text() -> void {
+  auto constexpr pixelHeight = 64.;
+  std::vector<stbtt_aligned_quad> quads {};
+  append_baked_quads("A B", pixelHeight, {10., 20.}, quads);
+  // The space takes up room but doesn't have a quad.
+  CHECK(quads.size() == 2);
+  auto const width = FontString::get_text_width("A B", pixelHeight);
+  CHECK(quads[0].x0 >= 9.F and quads[1].x1 <= 10. + width + 1.);
+  CHECK(quads[1].x0 > quads[0].x1);
+  // The text hangs down from its top left corner.
+  for (auto const& quad : quads) {
+    CHECK(quad.y0 >= 19.F and quad.y1 <= 20. + pixelHeight);
+    CHECK(quad.s0 >= 0.F and quad.s1 <= 1.F and quad.t0 >= 0.F and
+          quad.t1 <= 1.F);
+  }
+
+  // Twice as high text has twice as big quads of the same baked character.
+  std::vector<stbtt_aligned_quad> doubled {};
+  append_baked_quads("A", pixelHeight * 2, {10., 20.}, doubled);
+  CHECK(doubled.size() == 1);
+  auto const near = [](float const lhs, float const rhs) {
+    return std::abs(lhs - rhs) < 0.01F;
+  };
+  CHECK(near(doubled[0].x1 - doubled[0].x0, 2 * (quads[0].x1 - quads[0].x0)));
+  CHECK(near(doubled[0].y1 - doubled[0].y0, 2 * (quads[0].y1 - quads[0].y0)));
+  CHECK(doubled[0].s0 == quads[0].s0 and doubled[0].t1 == quads[0].t1);
+}
+
+auto run() -> void {
+  remove_full_rows();
+  rotation_systems();
+  shape_pool();
+  versus();
+  snapshots();
+  rollback();
+  thread_pool();
+  blend();
+  rect_rasterization();
+  damage();
+  capture();
+  terminal_screen();
+  spectate();
+  baked_text();
+}
 } // namespace tests
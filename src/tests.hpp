@@ -2,5 +2,18 @@
 
 namespace tests {
 auto remove_full_rows() -> void;
+auto rotation_systems() -> void;
+auto shape_pool() -> void;
+auto versus() -> void;
+auto snapshots() -> void;
+auto rollback() -> void;
+auto thread_pool() -> void;
+auto blend() -> void;
+auto rect_rasterization() -> void;
+auto damage() -> void;
+auto capture() -> void;
+auto terminal_screen() -> void;
+auto spectate() -> void;
+auto baked_text() -> void;
 auto run() -> void;
 } // namespace tests
@@ -0,0 +1,97 @@
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(std::size_t const threadCount) {
+  auto const workerCount = std::max<std::size_t>(1, threadCount) - 1;
+  m_workers.reserve(workerCount);
+  for (std::size_t i {0}; i < workerCount; ++i) {
+    m_workers.emplace_back(&ThreadPool::worker_loop, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock {m_mutex};
+    m_stopping = true;
+  }
+  m_wakeWorkers.notify_all();
+  for (auto& worker : m_workers) {
+    worker.join();
+  }
+}
+
+auto ThreadPool::run(std::size_t const jobCount, JobFunction const function,
+                     void* const context) -> void {
+  if (jobCount == 0) {
+    return;
+  }
+  if (jobCount == 1 or m_workers.empty()) {
+    for (std::size_t i {0}; i < jobCount; ++i) {
+      function(context, i);
+    }
+    return;
+  }
+
+  {
+    std::unique_lock lock {m_mutex};
+    // A worker that woke up too late for the last batch might still be
+    // looking for jobs, and must not take one from this batch with the last
+    // batch's function.
+    m_workDone.wait(lock, [this]() { return m_busyWorkers == 0; });
+    m_function = function;
+    m_context = context;
+    m_jobCount = jobCount;
+    m_nextJob = 0;
+    m_remainingJobs = jobCount;
+    ++m_generation;
+  }
+  m_wakeWorkers.notify_all();
+
+  work(function, context, jobCount);
+
+  std::unique_lock lock {m_mutex};
+  m_workDone.wait(lock, [this]() { return m_remainingJobs == 0; });
+}
+
+auto ThreadPool::work(JobFunction const function, void* const context,
+                      std::size_t const jobCount) -> void {
+  for (auto i = m_nextJob++; i < jobCount; i = m_nextJob++) {
+    function(context, i);
+    if (--m_remainingJobs == 0) {
+      // Lock so the notification can't slip in between the caller checking
+      // the count and starting to wait.
+      std::lock_guard lock {m_mutex};
+      m_workDone.notify_all();
+    }
+  }
+}
+
+auto ThreadPool::worker_loop() -> void {
+  std::size_t seenGeneration {0};
+  for (;;) {
+    JobFunction function {};
+    void* context {};
+    std::size_t jobCount {0};
+    {
+      std::unique_lock lock {m_mutex};
+      m_wakeWorkers.wait(lock, [this, seenGeneration]() {
+        return m_stopping or m_generation != seenGeneration;
+      });
+      if (m_stopping) {
+        return;
+      }
+      seenGeneration = m_generation;
+      function = m_function;
+      context = m_context;
+      jobCount = m_jobCount;
+      ++m_busyWorkers;
+    }
+
+    work(function, context, jobCount);
+
+    {
+      std::lock_guard lock {m_mutex};
+      --m_busyWorkers;
+    }
+    m_workDone.notify_all();
+  }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// A fixed set of worker threads that stay parked until work is handed to
+// them, so splitting up work every frame doesn't pay for creating threads.
+class ThreadPool {
+public:
+  // Work smaller than this isn't worth waking up another thread for.
+  std::size_t static constexpr minPixelsPerJob {16 * 1024};
+
+  // The calling thread also works on every batch, so a pool of N threads
+  // only creates N - 1 workers.
+  explicit ThreadPool(
+      std::size_t threadCount = std::thread::hardware_concurrency());
+  ThreadPool(ThreadPool const&) = delete;
+  auto operator=(ThreadPool const&) -> ThreadPool& = delete;
+  ~ThreadPool();
+
+  [[nodiscard]] auto thread_count() const noexcept -> std::size_t {
+    return m_workers.size() + 1;
+  }
+
+  // Calls job(i) for every i in [0, jobCount) across the pool and returns
+  // once all of them are done.
+  template <typename Job>
+  auto for_each(std::size_t const jobCount, Job&& job) -> void {
+    run(jobCount, [](void* context, std::size_t const i) {
+      (*static_cast<std::remove_reference_t<Job>*>(context))(i);
+    }, &job);
+  }
+
+  // Splits `rowCount` rows of `pixelsPerRow` pixels each into jobs of
+  // roughly minPixelsPerJob pixels and calls job(startRow, endRow) for each
+  // of them, so small areas aren't split into ranges that are mostly empty
+  // and large ones are balanced no matter how many threads there are.
+  template <typename Job>
+  auto for_each_row_range(std::size_t const rowCount,
+                          std::size_t const pixelsPerRow, Job&& job) -> void {
+    if (rowCount == 0) {
+      return;
+    }
+    auto const rowsPerJob = std::max<std::size_t>(
+        1, minPixelsPerJob / std::max<std::size_t>(1, pixelsPerRow));
+    auto const jobCount = (rowCount + rowsPerJob - 1) / rowsPerJob;
+    for_each(jobCount, [&job, rowCount, rowsPerJob](std::size_t const i) {
+      job(i * rowsPerJob, std::min(rowCount, (i + 1) * rowsPerJob));
+    });
+  }
+
+private:
+  using JobFunction = void (*)(void* context, std::size_t i);
+
+  auto run(std::size_t jobCount, JobFunction function, void* context)
+      -> void;
+  // Takes jobs until there are none left.
+  auto work(JobFunction function, void* context, std::size_t jobCount)
+      -> void;
+  auto worker_loop() -> void;
+
+  std::vector<std::thread> m_workers {};
+  std::mutex m_mutex {};
+  std::condition_variable m_wakeWorkers {};
+  std::condition_variable m_workDone {};
+
+  // Guarded by m_mutex.
+  std::size_t m_generation {0};
+  std::size_t m_busyWorkers {0};
+  bool m_stopping {false};
+  JobFunction m_function {};
+  void* m_context {};
+  std::size_t m_jobCount {0};
+
+  std::atomic<std::size_t> m_nextJob {0};
+  std::atomic<std::size_t> m_remainingJobs {0};
+};
@@ -0,0 +1,198 @@
+#include "thumbnails.hpp"
+
+#include "thread_pool.hpp"
+
+#include "fmt/core.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Thumbnails {
+
+namespace {
+
+// The space between tiles.
+std::array<u8, 3> constexpr separatorColor {0x20, 0x20, 0x20};
+
+[[nodiscard]] auto block_from(char const c) -> std::optional<Block> {
+  switch (c) {
+  case '.':
+    return Block {Block::Kind::Empty};
+  case 'I':
+    return Block {Block::Kind::I};
+  case 'O':
+    return Block {Block::Kind::O};
+  case 'L':
+    return Block {Block::Kind::L};
+  case 'J':
+    return Block {Block::Kind::J};
+  case 'S':
+    return Block {Block::Kind::S};
+  case 'Z':
+    return Block {Block::Kind::Z};
+  case 'T':
+    return Block {Block::Kind::T};
+  case 'G':
+    return Block {Block::Kind::Garbage};
+  default:
+    return std::nullopt;
+  }
+}
+
+[[nodiscard]] auto to_rgb(Color::RGBA const color) -> std::array<u8, 3> {
+  return {u8 {color.r}, u8 {color.g}, u8 {color.b}};
+}
+
+} // namespace
+
+auto parse_position(std::string_view line) -> std::optional<Position> {
+  // Lines written on Windows end in a carriage return.
+  if (not line.empty() and line.back() == '\r') {
+    line.remove_suffix(1);
+  }
+  auto constexpr hiddenCells =
+      std::size_t {Board::rows - Board::visibleRows} * Board::columns;
+  Position position {};
+  if (line.size() == position.size() + hiddenCells) {
+    line.remove_prefix(hiddenCells);
+  } else if (line.size() != position.size()) {
+    return std::nullopt;
+  }
+
+  for (std::size_t i {0}; i < position.size(); ++i) {
+    auto const block = block_from(line[i]);
+    if (not block) {
+      return std::nullopt;
+    }
+    position[i] = *block;
+  }
+  return position;
+}
+
+auto AtlasLayout::size() const -> Rect<int>::Size {
+  auto const tile = tile_size();
+  return {columns * (tile.w + 1) + 1, rows * (tile.h + 1) + 1};
+}
+
+auto AtlasLayout::tile_origin(std::size_t const tile) const -> Point<int> {
+  auto const size = tile_size();
+  auto const column = static_cast<int>(tile) % columns;
+  auto const row = static_cast<int>(tile) / columns;
+  return {1 + column * (size.w + 1), 1 + row * (size.h + 1)};
+}
+
+Atlas::Atlas(AtlasLayout const layout)
+    : m_layout {layout},
+      m_pixels(static_cast<std::size_t>(layout.size().w * layout.size().h) *
+               3) {
+  clear();
+}
+
+auto Atlas::clear() -> void {
+  for (std::size_t i {0}; i < m_pixels.size(); i += 3) {
+    std::memcpy(&m_pixels[i], separatorColor.data(), separatorColor.size());
+  }
+}
+
+auto Atlas::draw_tile(std::size_t const tile,
+                      std::optional<Position> const& position) -> void {
+  auto const cellSize = static_cast<std::size_t>(m_layout.cellSize);
+  auto const rowSize = static_cast<std::size_t>(m_layout.size().w) * 3;
+  auto const origin = m_layout.tile_origin(tile);
+  auto* const tilePixels = m_pixels.data() +
+                           static_cast<std::size_t>(origin.y) * rowSize +
+                           static_cast<std::size_t>(origin.x) * 3;
+  auto const tileRowSize = static_cast<std::size_t>(Board::columns) *
+                           cellSize * 3;
+
+  // The first row of pixels of every row of cells is expanded from the
+  // cells' colors, and the rest of them are copies of it.
+  for (std::size_t y {0}; y < Board::visibleRows; ++y) {
+    auto* const firstRow = tilePixels + y * cellSize * rowSize;
+    for (std::size_t x {0}; x < Board::columns; ++x) {
+      auto const rgb = to_rgb(
+          position ? (*position)[y * Board::columns + x].color()
+                   : Color::invalid);
+      auto* pixel = firstRow + x * cellSize * 3;
+      for (std::size_t i {0}; i < cellSize; ++i, pixel += 3) {
+        std::memcpy(pixel, rgb.data(), rgb.size());
+      }
+    }
+    for (std::size_t i {1}; i < cellSize; ++i) {
+      std::memcpy(firstRow + i * rowSize, firstRow, tileRowSize);
+    }
+  }
+}
+
+auto Atlas::write_ppm(std::FILE* const file) const -> bool {
+  auto const size = m_layout.size();
+  fmt::print(file, "P6\n{} {}\n255\n", size.w, size.h);
+  return std::fwrite(m_pixels.data(), 1, m_pixels.size(), file) ==
+         m_pixels.size();
+}
+
+auto render(std::istream& input, std::string const& prefix,
+            AtlasLayout const layout, std::size_t const threadCount)
+    -> bool {
+  ThreadPool pool {threadCount};
+  Atlas atlas {layout};
+  std::vector<std::string> lines {};
+  lines.reserve(layout.tiles_per_atlas());
+
+  std::size_t atlasCount {0};
+  std::size_t positionCount {0};
+  std::size_t invalidCount {0};
+  std::string line {};
+  auto more = true;
+  while (more) {
+    lines.clear();
+    while (lines.size() < layout.tiles_per_atlas() and
+           (more = static_cast<bool>(std::getline(input, line)))) {
+      if (not line.empty() and line != "\r") {
+        lines.push_back(line);
+      }
+    }
+    if (lines.empty()) {
+      break;
+    }
+
+    // Every line is parsed on the thread that draws its tile. Tiles don't
+    // overlap, so they're all drawn at the same time.
+    std::vector<u8> invalid(lines.size());
+    // Only the last atlas can have tiles left over from the one before.
+    if (lines.size() < layout.tiles_per_atlas() and atlasCount > 0) {
+      atlas.clear();
+    }
+    pool.for_each(lines.size(), [&](std::size_t const i) {
+      auto const position = parse_position(lines[i]);
+      invalid[i] = position ? 0 : 1;
+      atlas.draw_tile(i, position);
+    });
+    for (std::size_t i {0}; i < lines.size(); ++i) {
+      if (invalid[i]) {
+        std::fprintf(stderr, "Position %zu isn't a board\n",
+                     positionCount + i);
+        ++invalidCount;
+      }
+    }
+
+    auto const path = fmt::format("{}_{}.ppm", prefix, atlasCount);
+    auto* const file = std::fopen(path.c_str(), "wb");
+    auto const written = file and atlas.write_ppm(file);
+    if (file) {
+      std::fclose(file);
+    }
+    if (not written) {
+      std::fprintf(stderr, "Couldn't write %s\n", path.c_str());
+      return false;
+    }
+    ++atlasCount;
+    positionCount += lines.size();
+  }
+
+  fmt::print("Rendered {} positions into {} atlases, {} of them invalid\n",
+             positionCount, atlasCount, invalidCount);
+  return true;
+}
+
+} // namespace Thumbnails
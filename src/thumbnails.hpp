@@ -0,0 +1,81 @@
+#pragma once
+
+#include "board.hpp"
+#include "util.hpp"
+
+#include "jint.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Renders board positions, e.g. from replays or search logs, as small tiles
+// packed into big atlas images for reviewing lots of them at once. None of it
+// needs a window or SDL, so it's built into a tool of its own.
+//
+// Positions are read one per line, as a character for every cell of the board
+// row by row from the top: '.' for an empty cell, one of IOLJSZT for a shape's
+// block and G for garbage. A line has either the 20 visible rows or all 22
+// rows of the board, in which case the hidden ones aren't drawn. Empty lines
+// are skipped.
+namespace Thumbnails {
+
+using Position = std::array<Block, Board::columns * Board::visibleRows>;
+
+[[nodiscard]] auto parse_position(std::string_view line)
+    -> std::optional<Position>;
+
+// Tiles are placed left to right and top to bottom, with a pixel between
+// them, so the Nth position of the input is tile N % tiles_per_atlas() of
+// atlas N / tiles_per_atlas().
+struct AtlasLayout {
+  int cellSize {4};
+  int columns {32};
+  int rows {16};
+
+  [[nodiscard]] auto tiles_per_atlas() const -> std::size_t {
+    return static_cast<std::size_t>(columns * rows);
+  }
+  [[nodiscard]] auto tile_size() const -> Rect<int>::Size {
+    return {Board::columns * cellSize, Board::visibleRows * cellSize};
+  }
+  [[nodiscard]] auto size() const -> Rect<int>::Size;
+  [[nodiscard]] auto tile_origin(std::size_t tile) const -> Point<int>;
+};
+
+// An atlas image with 3 bytes of RGB for every pixel.
+class Atlas {
+public:
+  explicit Atlas(AtlasLayout layout);
+
+  // Fills the tile with its cells' colors. A tile for a position that
+  // couldn't be parsed is filled with Color::invalid instead.
+  auto draw_tile(std::size_t tile, std::optional<Position> const& position)
+      -> void;
+  // Clears every tile, e.g. before drawing the next atlas into it.
+  auto clear() -> void;
+  // Writes the atlas as a binary PPM.
+  auto write_ppm(std::FILE* file) const -> bool;
+
+  [[nodiscard]] auto layout() const -> AtlasLayout const& { return m_layout; }
+  [[nodiscard]] auto pixels() const -> std::vector<u8> const& {
+    return m_pixels;
+  }
+
+private:
+  AtlasLayout m_layout;
+  std::vector<u8> m_pixels;
+};
+
+// Reads positions from `input` until it ends and writes them to
+// `<prefix>_0.ppm`, `<prefix>_1.ppm` and so on, drawing the tiles of each
+// atlas on `threadCount` threads. Returns whether every atlas was written.
+auto render(std::istream& input, std::string const& prefix,
+            AtlasLayout layout, std::size_t threadCount) -> bool;
+
+} // namespace Thumbnails
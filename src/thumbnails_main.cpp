@@ -0,0 +1,43 @@
+#include "thumbnails.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Renders the positions read from stdin into atlases, see thumbnails.hpp.
+auto main(int argc, char** argv) -> int {
+  Thumbnails::AtlasLayout layout {};
+  std::size_t threadCount {std::max(1U, std::thread::hardware_concurrency())};
+  std::optional<std::string> prefix {};
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg {argv[i]};
+    using namespace std::string_view_literals;
+    if (arg == "-cell"sv and i + 1 < argc) {
+      layout.cellSize = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "-columns"sv and i + 1 < argc) {
+      layout.columns = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "-rows"sv and i + 1 < argc) {
+      layout.rows = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "-threads"sv and i + 1 < argc) {
+      threadCount = static_cast<std::size_t>(std::max(1, std::atoi(argv[++i])));
+    } else {
+      prefix = arg;
+    }
+  }
+
+  if (not prefix) {
+    std::fprintf(stderr,
+                 "Usage: %s [-cell N] [-columns N] [-rows N] [-threads N] "
+                 "PREFIX < positions\n",
+                 argv[0]);
+    return 1;
+  }
+
+  std::ios::sync_with_stdio(false);
+  return Thumbnails::render(std::cin, *prefix, layout, threadCount) ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+#include "check.hpp"
+#include "thumbnails.hpp"
+
+#include <algorithm>
+#include <string>
+
+// The tool's tests, which are kept out of the game since it doesn't link the
+// tool's code. Run by ctest.
+auto static parsing_and_drawing() -> void {
+  // A T on an empty row, over a row of garbage with a hole.
+  std::string visible(std::size_t {Board::columns} * (Board::visibleRows - 2),
+                      '.');
+  visible += "...T......";
+  visible += "GGGG.GGGGG";
+  auto const position = Thumbnails::parse_position(visible);
+  CHECK(position);
+  auto const at = [&position](int const x, int const y) {
+    return (*position)[static_cast<std::size_t>(y * Board::columns + x)].kind;
+  };
+  CHECK(at(3, Board::visibleRows - 2) == Block::Kind::T);
+  CHECK(at(4, Board::visibleRows - 1) == Block::Kind::Empty);
+  CHECK(at(5, Board::visibleRows - 1) == Block::Kind::Garbage);
+
+  // The hidden rows can be included, and Windows line endings are fine.
+  auto const whole = std::string(2 * Board::columns, 'I') + visible + "\r";
+  auto const wholePosition = Thumbnails::parse_position(whole);
+  CHECK(wholePosition);
+  CHECK(std::equal(wholePosition->begin(), wholePosition->end(),
+                    position->begin(),
+                    [](Block const lhs, Block const rhs) {
+                      return lhs.kind == rhs.kind;
+                    }));
+  CHECK(not Thumbnails::parse_position(visible.substr(1)));
+  CHECK(not Thumbnails::parse_position(std::string(visible.size(), 'X')));
+
+  Thumbnails::AtlasLayout const layout {2, 3, 2};
+  CHECK(layout.size().w == 3 * (Board::columns * 2 + 1) + 1);
+  CHECK(layout.size().h == 2 * (Board::visibleRows * 2 + 1) + 1);
+  Thumbnails::Atlas atlas {layout};
+  atlas.draw_tile(4, position);
+  atlas.draw_tile(5, std::nullopt);
+
+  auto const pixel = [&atlas, &layout](Point<int> const point) {
+    auto const i = static_cast<std::size_t>(
+        (point.y * layout.size().w + point.x) * 3);
+    auto const& pixels = atlas.pixels();
+    return Color::RGBA {pixels[i], pixels[i + 1], pixels[i + 2]};
+  };
+  auto const same = [](Color::RGBA const lhs, Color::RGBA const rhs) {
+    return u8 {lhs.r} == u8 {rhs.r} and u8 {lhs.g} == u8 {rhs.g} and
+           u8 {lhs.b} == u8 {rhs.b};
+  };
+  auto const origin = layout.tile_origin(4);
+  auto const cell = [&](int const x, int const y) {
+    return Point<int> {origin.x + x * 2 + 1, origin.y + y * 2 + 1};
+  };
+  CHECK(same(pixel(cell(3, Board::visibleRows - 2)),
+              ShapeBase::to_color(ShapeBase::Type::T)));
+  CHECK(same(pixel(cell(0, 0)), Color::black));
+  CHECK(same(pixel(cell(5, Board::visibleRows - 1)), Color::garbage));
+  CHECK(same(pixel(layout.tile_origin(5)), Color::invalid));
+  // Nothing is drawn between the tiles.
+  CHECK(same(pixel({origin.x - 1, origin.y}), Color::RGBA {0x20U, 0x20U,
+                                                            0x20U}));
+}
+
+auto main() -> int {
+  parsing_and_drawing();
+  return 0;
+}
@@ -4,8 +4,11 @@
 
 #include <gsl/gsl>
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <exception>
+#include <optional>
 
 using gsl::narrow_cast;
 
@@ -203,6 +206,9 @@ RGBA static constexpr transparent {0U, 0U, 0U, RGBA::Alpha::transparent};
 // hopefully it will be obvious that something is wrong.
 RGBA static constexpr invalid {white};
 
+// Rows of garbage sent by an opponent in versus.
+RGBA static constexpr garbage {0x80U, 0x80U, 0x80U};
+
 struct Shape {
   RGBA static constexpr I {0U, 0xF0U, 0xF0U};
   RGBA static constexpr O {0xF0U, 0xF0U, 0U};
@@ -214,6 +220,29 @@ struct Shape {
 };
 } // namespace Color
 
+// The layouts of pixels the software renderer can draw into, named like SDL
+// names them. The 32 and 16 bit formats are stored in little endian.
+enum class PixelFormat : u8 {
+  XRGB8888, // B, G, R and an unused byte.
+  ARGB8888, // B, G, R and A.
+  RGB565,   // 5 bits of red at the top, then 6 of green and 5 of blue.
+  BGR24,    // B, G and R.
+};
+
+[[nodiscard]] auto constexpr bytes_per_pixel(PixelFormat const format) -> u8 {
+  switch (format) {
+  case PixelFormat::XRGB8888:
+  case PixelFormat::ARGB8888:
+    return 4;
+  case PixelFormat::RGB565:
+    return 2;
+  case PixelFormat::BGR24:
+    return 3;
+  }
+  // Unreachable.
+  std::terminate();
+}
+
 template <typename T>
 struct Rect {
   T x {};
@@ -331,6 +360,20 @@ template <typename T>
          (point.y >= rect.y) and (point.y < rect.y + rect.h);
 }
 
+// The part of both rects that overlaps, if any.
+template <typename T>
+[[nodiscard]] auto rect_intersection(Rect<T> const& lhs, Rect<T> const& rhs)
+    -> std::optional<Rect<T>> {
+  auto const x = std::max(lhs.x, rhs.x);
+  auto const y = std::max(lhs.y, rhs.y);
+  auto const endX = std::min(lhs.x + lhs.w, rhs.x + rhs.w);
+  auto const endY = std::min(lhs.y + lhs.h, rhs.y + rhs.h);
+  if (x >= endX or y >= endY) {
+    return std::nullopt;
+  }
+  return Rect<T> {x, y, endX - x, endY - y};
+}
+
 // This won't work if T doesn't have a default constructor. If it does have
 // one, there's a potential performance hit from default constructing every
 // element and then immediately reassigning all of them.
@@ -0,0 +1,204 @@
+#include "versus.hpp"
+
+#include "fmt/core.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace Versus {
+
+auto attack_lines(LockResult const& result) -> int {
+  auto const baseAttack = [&result]() {
+    switch (result.clearType) {
+    case ClearType::None:
+    case ClearType::Single:
+    case ClearType::Tspin:
+    case ClearType::Tspin_mini:
+    case ClearType::Tspin_mini_single:
+      return 0;
+    case ClearType::Double:
+    case ClearType::Tspin_mini_double:
+      return 1;
+    case ClearType::Triple:
+    case ClearType::Tspin_single:
+      return 2;
+    case ClearType::Tetris:
+    case ClearType::Tspin_double:
+      return 4;
+    case ClearType::Tspin_triple:
+      return 6;
+    }
+    // Unreachable.
+    std::terminate();
+  }();
+
+  if (result.rowsCleared == 0) {
+    return 0;
+  }
+
+  std::array static constexpr comboAttack {0, 1, 1, 2, 2, 3, 3, 4, 4, 4, 5};
+  auto const comboIndex = std::clamp<std::size_t>(
+      static_cast<std::size_t>(std::max(result.comboCounter, 0)), 0,
+      comboAttack.size() - 1);
+
+  return baseAttack + (result.backToBack ? 1 : 0) + comboAttack[comboIndex];
+}
+
+auto GarbageQueue::push(Garbage const garbage) -> void {
+  if (m_size == capacity) {
+    auto& newest = m_data[m_size - 1];
+    newest.lines = static_cast<u8>(std::min(newest.lines + garbage.lines,
+                                            int {Board::rows}));
+    return;
+  }
+  m_data[m_size++] = garbage;
+}
+
+auto GarbageQueue::cancel(int lines) -> int {
+  std::size_t cancelled {0};
+  while (cancelled < m_size and lines > 0) {
+    auto& oldest = m_data[cancelled];
+    auto const removed = std::min(lines, int {oldest.lines});
+    oldest.lines = static_cast<u8>(oldest.lines - removed);
+    lines -= removed;
+    if (oldest.lines == 0) {
+      ++cancelled;
+    }
+  }
+  std::move(m_data.begin() + narrow_cast<std::ptrdiff_t>(cancelled),
+            m_data.begin() + narrow_cast<std::ptrdiff_t>(m_size),
+            m_data.begin());
+  m_size = narrow_cast<u8>(m_size - cancelled);
+  return lines;
+}
+
+auto GarbageQueue::total_lines() const -> int {
+  auto lines = 0;
+  for (auto const& garbage : *this) {
+    lines += garbage.lines;
+  }
+  return lines;
+}
+
+auto counter_garbage(Player& player, int const attack) -> int {
+  auto const sent = player.incomingGarbage.cancel(attack);
+  player.linesSent += sent;
+  return sent;
+}
+
+auto insert_garbage(Player& player) -> void {
+  auto& gameState = player.gameState;
+  for (auto const& garbage : player.incomingGarbage) {
+    player.linesReceived += garbage.lines;
+    if (not gameState.board.add_garbage_rows(garbage.lines,
+                                             garbage.holeColumn)) {
+      gameState.gameOver = true;
+    }
+  }
+  player.incomingGarbage.clear();
+
+  // The current shape has already spawned, so the garbage might have risen
+  // into it.
+  if (not gameState.board.is_valid_shape(gameState.currentShape)) {
+    gameState.gameOver = true;
+  }
+  gameState.currentShapeShadow =
+      gameState.board.get_shadow(gameState.currentShape);
+}
+
+auto RandomBot::next_input() -> Input {
+  using Action = Input::Action;
+  auto const roll = [this](std::size_t const oneIn) {
+    return Randomizer::random_index(m_engine, oneIn) == 0;
+  };
+
+  Input input {};
+  if (roll(8)) {
+    input.set(roll(2) ? Action::Move_left : Action::Move_right);
+  }
+  if (roll(12)) {
+    input.set(roll(2) ? Action::Rotate_left : Action::Rotate_right);
+  }
+  if (roll(40)) {
+    input.set(Action::Hold);
+  }
+  if (roll(30)) {
+    input.set(Action::Drop);
+  }
+  return input;
+}
+
+namespace {
+
+struct MatchResult {
+  std::optional<std::size_t> winner;
+  u64 ticks;
+};
+
+auto constexpr tournamentLevel = 5;
+// Bots that never clear anything still top out eventually, but a match
+// between two lucky ones is cut off to keep the tournament bounded.
+u64 constexpr maxTicks {60 * 60 * 10};
+
+[[nodiscard]] auto play_random_match(Randomizer::Engine::result_type const seed)
+    -> MatchResult {
+  Match<2> match {tournamentLevel, seed};
+  std::array bots {RandomBot {seed * 2 + 1}, RandomBot {seed * 2 + 2}};
+  while (not match.is_over() and match.tick() < maxTicks) {
+    match.step({bots[0].next_input(), bots[1].next_input()});
+  }
+  return {match.is_over() ? match.winner() : std::nullopt, match.tick()};
+}
+
+} // namespace
+
+auto run_headless_tournament(int const matchCount) -> void {
+  auto const threadCount =
+      std::max(1U, std::thread::hardware_concurrency());
+  std::vector<MatchResult> results(static_cast<std::size_t>(matchCount));
+  std::atomic<std::size_t> nextMatch {0};
+
+  auto const start = std::chrono::steady_clock::now();
+  {
+    std::vector<std::thread> threads {};
+    threads.reserve(threadCount);
+    for (uint i {0}; i < threadCount; ++i) {
+      threads.emplace_back([&results, &nextMatch]() {
+        for (auto m = nextMatch++; m < results.size(); m = nextMatch++) {
+          results[m] = play_random_match(
+              static_cast<Randomizer::Engine::result_type>(m + 1));
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+  std::chrono::duration<double> const elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  std::array<int, 2> wins {};
+  auto draws = 0;
+  u64 ticks {0};
+  for (auto const& result : results) {
+    if (result.winner) {
+      ++wins[*result.winner];
+    } else {
+      ++draws;
+    }
+    ticks += result.ticks;
+  }
+
+  fmt::print("{} matches in {:.2f}s on {} threads ({:.0f} matches/min, "
+             "{:.0f} ticks/s)\n",
+             matchCount, elapsed.count(), threadCount,
+             matchCount / elapsed.count() * 60.,
+             static_cast<double>(ticks) / elapsed.count());
+  fmt::print("Player 1 wins: {}, player 2 wins: {}, unfinished or drawn: {}\n",
+             wins[0], wins[1], draws);
+}
+
+} // namespace Versus
@@ -0,0 +1,224 @@
+#pragma once
+
+#include "core.hpp"
+#include "game.hpp"
+#include "shape_pool.hpp"
+#include "util.hpp"
+
+#include "jint.h"
+
+#include <array>
+#include <cassert>
+#include <optional>
+#include <utility>
+
+// Versus matches where every line cleared attacks an opponent with garbage.
+// Matches don't depend on the wall clock, the window or the UI, so they can be
+// stepped headless as fast as the CPU allows.
+namespace Versus {
+
+// The amount of garbage lines sent for a lock, following the guideline's
+// attack table including its back to back and combo bonuses.
+[[nodiscard]] auto attack_lines(LockResult const& result) -> int;
+
+struct Garbage {
+  u8 lines {0};
+  u8 holeColumn {0};
+
+  template <typename Archive>
+  auto serialize(Archive& archive) -> void {
+    archive(lines, holeColumn);
+    archive.check(holeColumn < Board::columns);
+  }
+};
+
+// Garbage waiting to be inserted into a player's board, oldest first.
+class GarbageQueue {
+public:
+  std::size_t static constexpr capacity {16};
+
+  // If the queue is full the garbage is added to the newest entry instead.
+  auto push(Garbage garbage) -> void;
+  // Removes up to `lines` lines from the queue and returns how many of them
+  // were left over.
+  auto cancel(int lines) -> int;
+  auto clear() -> void { m_size = 0; }
+
+  [[nodiscard]] auto total_lines() const -> int;
+  [[nodiscard]] auto begin() const { return m_data.cbegin(); }
+  [[nodiscard]] auto end() const {
+    return m_data.cbegin() + narrow_cast<std::ptrdiff_t>(m_size);
+  }
+  [[nodiscard]] auto empty() const -> bool { return m_size == 0; }
+
+  template <typename Archive>
+  auto serialize(Archive& archive) -> void {
+    archive(m_data, m_size);
+    archive.check(m_size <= capacity);
+  }
+
+private:
+  std::array<Garbage, capacity> m_data {};
+  u8 m_size {0};
+};
+
+struct Player {
+  Player(int const startingLevel, GameClock::time_point const startClock,
+         Randomizer::Engine::result_type const seed)
+      : gameState {startingLevel, startClock, seed} {}
+
+  GameState gameState;
+  GarbageQueue incomingGarbage {};
+  int linesSent {0};
+  int linesReceived {0};
+
+  template <typename Archive>
+  auto serialize(Archive& archive) -> void {
+    archive(gameState, incomingGarbage, linesSent, linesReceived);
+    archive.check(linesSent >= 0 and linesReceived >= 0);
+  }
+};
+
+// Attacks the player, returning how many lines were actually sent after
+// cancelling the player's own incoming garbage.
+auto counter_garbage(Player& player, int attack) -> int;
+// Inserts all of the player's incoming garbage into its board, which ends the
+// player's game if it gets pushed out of the top.
+auto insert_garbage(Player& player) -> void;
+
+// Steps every player's game in lockstep on a deterministic clock, one tick per
+// call. The whole match is a plain value, so it can be copied to save it.
+template <std::size_t playerCount>
+class Match {
+  static_assert(playerCount >= 2, "A versus match needs an opponent.");
+
+public:
+  using Inputs = std::array<Input, playerCount>;
+
+  // Every tick is as long as a frame of the interactive game.
+  auto static constexpr tickDuration = ProgramState::targetFrameTime;
+
+  // Every player gets the same sequence of shapes.
+  explicit Match(int const startingLevel,
+                 Randomizer::Engine::result_type const seed)
+      : m_players {make_players(startingLevel, seed,
+                                std::make_index_sequence<playerCount> {})},
+        m_engine {seed} {}
+
+  auto step(Inputs const& inputs) -> void {
+    auto const currentTime = now();
+    for (std::size_t i {0}; i < playerCount; ++i) {
+      auto& gameState = m_players[i].gameState;
+      if (gameState.gameOver) {
+        continue;
+      }
+
+      apply_input(gameState, inputs[i], currentTime);
+      if (auto const result = update_game(gameState, currentTime)) {
+        handle_lock(i, *result);
+      }
+    }
+    ++m_tick;
+  }
+
+  [[nodiscard]] auto alive_count() const -> std::size_t {
+    std::size_t count {0};
+    for (auto const& player : m_players) {
+      count += player.gameState.gameOver ? 0 : 1;
+    }
+    return count;
+  }
+
+  [[nodiscard]] auto is_over() const -> bool { return alive_count() <= 1; }
+
+  // Only valid once the match is over. A draw, i.e. every player topping out
+  // on the same tick, has no winner.
+  [[nodiscard]] auto winner() const -> std::optional<std::size_t> {
+    assert(is_over());
+    for (std::size_t i {0}; i < playerCount; ++i) {
+      if (not m_players[i].gameState.gameOver) {
+        return i;
+      }
+    }
+    return std::nullopt;
+  }
+
+  [[nodiscard]] auto players() const
+      -> std::array<Player, playerCount> const& {
+    return m_players;
+  }
+  [[nodiscard]] auto player(std::size_t const i) const -> Player const& {
+    return m_players[i];
+  }
+  [[nodiscard]] auto tick() const -> u64 { return m_tick; }
+  [[nodiscard]] auto now() const -> GameClock::time_point {
+    return GameClock::time_point {} +
+           tickDuration * static_cast<GameClock::rep>(m_tick);
+  }
+
+  // Visits every field, see snapshot.hpp.
+  template <typename Archive>
+  auto serialize(Archive& archive) -> void {
+    archive(m_players, m_engine, m_tick);
+  }
+
+private:
+  template <std::size_t... i>
+  [[nodiscard]] auto static make_players(
+      int const startingLevel, Randomizer::Engine::result_type const seed,
+      std::index_sequence<i...> /*indices*/)
+      -> std::array<Player, playerCount> {
+    return {((void)i, Player {startingLevel, GameClock::time_point {}, seed})...};
+  }
+
+  // Garbage is sent to the next player that is still alive.
+  [[nodiscard]] auto target_of(std::size_t const attacker) const
+      -> std::optional<std::size_t> {
+    for (std::size_t offset {1}; offset < playerCount; ++offset) {
+      auto const target = (attacker + offset) % playerCount;
+      if (not m_players[target].gameState.gameOver) {
+        return target;
+      }
+    }
+    return std::nullopt;
+  }
+
+  auto handle_lock(std::size_t const i, LockResult const& result) -> void {
+    auto& player = m_players[i];
+    if (auto const attack = counter_garbage(player, attack_lines(result))) {
+      if (auto const target = target_of(i)) {
+        auto const holeColumn = static_cast<u8>(
+            Randomizer::random_index(m_engine, Board::columns));
+        m_players[*target].incomingGarbage.push(
+            {static_cast<u8>(attack), holeColumn});
+      }
+    }
+
+    // Garbage only rises when the lock didn't clear any rows.
+    if (result.rowsCleared == 0 and not player.gameState.gameOver) {
+      insert_garbage(player);
+    }
+  }
+
+  std::array<Player, playerCount> m_players;
+  Randomizer::Engine m_engine;
+  u64 m_tick {0};
+};
+
+// Presses random buttons. Used to drive matches without any players.
+class RandomBot {
+public:
+  explicit RandomBot(Randomizer::Engine::result_type const seed)
+      : m_engine {seed} {}
+
+  [[nodiscard]] auto next_input() -> Input;
+
+private:
+  Randomizer::Engine m_engine;
+};
+
+// Plays `matchCount` matches between bots pressing random buttons as fast as
+// possible and prints the results. Used to measure the engine's throughput.
+auto run_headless_tournament(int matchCount) -> void;
+
+} // namespace Versus